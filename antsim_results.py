@@ -0,0 +1,79 @@
+"""Loader for the binary results files written with <binary_output path="..."/>
+
+Example:
+    import antsim_results
+    runs = antsim_results.load_runs("results.antsim")
+    for params, columns in antsim_results.select_runs(runs, iter=0):
+        print(params["mal_frac"], columns["food_found_per_ant"][-1])
+
+With <summary> active, the statistics of the iterations of each configuration are runs with a "runs"
+parameter instead of "iter", see split_summaries.
+"""
+import struct
+import numpy as np
+
+MAGIC = b"ANTSIMR\0"
+VERSION = 1
+
+
+def _read_string(data, offset):
+    (length,) = struct.unpack_from("<H", data, offset)
+    offset += 2
+    return data[offset:offset + length].decode(), offset + length
+
+
+def load_runs(path):
+    """Return the complete runs of a results file as a list of (parameters, columns) pairs.
+
+    parameters maps the parameter names to floats, columns maps the column names to float32 numpy arrays.
+    """
+    with open(path, "rb") as file:
+        data = file.read()
+    if data[:8] != MAGIC or struct.unpack_from("<I", data, 8)[0] != VERSION:
+        raise ValueError(path + " is not a results file")
+
+    runs = []
+    offset = 12
+    while offset + 4 <= len(data):
+        (record_size,) = struct.unpack_from("<I", data, offset)
+        offset += 4
+        end = offset + record_size
+        if end > len(data):
+            # Truncated last run
+            break
+        (parameter_count,) = struct.unpack_from("<I", data, offset)
+        offset += 4
+        parameters = {}
+        for _ in range(parameter_count):
+            name, offset = _read_string(data, offset)
+            (parameters[name],) = struct.unpack_from("<d", data, offset)
+            offset += 8
+        column_count, row_count = struct.unpack_from("<II", data, offset)
+        offset += 8
+        names = []
+        for _ in range(column_count):
+            name, offset = _read_string(data, offset)
+            names.append(name)
+        values = np.frombuffer(data, dtype="<f4", count=column_count * row_count, offset=offset)
+        columns = {name: values[i * row_count:(i + 1) * row_count] for i, name in enumerate(names)}
+        runs.append((parameters, columns))
+        offset = end
+    return runs
+
+
+def select_runs(runs, **parameters):
+    """Keep the runs whose parameters have the given values, e.g. select_runs(runs, mal_frac=0.25, iter=0)"""
+    return [run for run in runs
+            if all(np.isclose(run[0][name], value) for name, value in parameters.items())]
+
+
+def split_summaries(runs):
+    """Separate the iteration runs from the summary runs, returns (iterations, summaries)"""
+    iterations = [run for run in runs if "runs" not in run[0]]
+    summaries = [run for run in runs if "runs" in run[0]]
+    return iterations, summaries
+
+
+def to_array(run):
+    """Series of a run as a (rows, columns) array, the layout of the CSV files"""
+    return np.column_stack(list(run[1].values()))
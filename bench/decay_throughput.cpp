@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "number_generator.hpp"
+#include "pheromone_decay.hpp"
+#include "utils.hpp"
+
+
+/**
+ * Cells per second of the evaporation kernels of every implementation the CPU supports, on a plane that stays in
+ * the caches (the default 480x270 cell world) and on one that doesn't (a 8K world, 1920x1080 cells).
+ */
+
+struct Plane
+{
+	std::vector<float> intensity;
+	std::vector<uint16_t> units;
+	std::vector<uint8_t> permanent;
+	std::vector<uint32_t> food;
+
+	explicit Plane(uint64_t count)
+	{
+		CounterRNG::setStream(1, count, 0);
+		for (uint64_t i(0); i < count; ++i) {
+			intensity.push_back(1000.0f * CounterRNG::nextFloat());
+			units.push_back(to<uint16_t>(CounterRNG::next() >> 48));
+			// A few permanent markers and food cells, as around the colony and the food of a map
+			permanent.push_back(CounterRNG::nextFloat() < 0.01f ? 0xFF : 0);
+			food.push_back(CounterRNG::nextFloat() < 0.01f ? 5 : 0);
+		}
+	}
+};
+
+// Cells per second of a kernel, best of a few repetitions
+template<typename Kernel>
+double measure(uint64_t count, Kernel kernel)
+{
+	const uint32_t passes = to<uint32_t>(std::max<uint64_t>(1, 200000000 / count));
+	double best = 0.0;
+	for (uint32_t repetition(0); repetition < 5; ++repetition) {
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint32_t pass(0); pass < passes; ++pass) {
+			kernel();
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = std::max(best, to<double>(count) * to<double>(passes) / seconds);
+	}
+	return best;
+}
+
+int main()
+{
+	const char* names[] = { "AVX2", "SSE2", "scalar" };
+	const uint64_t counts[] = { 480 * 270, 1920 * 1080 };
+	std::printf("%-8s %10s %17s %17s %17s %17s\n", "kernel", "cells", "channel", "food channel", "channel 16", "food channel 16");
+	for (uint64_t count : counts) {
+		Plane plane(count);
+		for (const char* name : names) {
+			if (!PheromoneDecay::setImplementation(name)) {
+				continue;
+			}
+			// Tiny rates keep most of the cells above 0 for all the passes
+			const double channel = measure(count, [&]() { PheromoneDecay::decayChannel(plane.intensity.data(), plane.permanent.data(), 1, 1e-6f, count); });
+			const double food_channel = measure(count, [&]() { PheromoneDecay::decayFoodChannel(plane.intensity.data(), plane.permanent.data(), plane.food.data(), 2, 1e-6f, count); });
+			const double channel_16 = measure(count, [&]() { PheromoneDecay::decayChannel(plane.units.data(), plane.permanent.data(), 1, 1, count); });
+			const double food_channel_16 = measure(count, [&]() { PheromoneDecay::decayFoodChannel(plane.units.data(), plane.permanent.data(), plane.food.data(), 2, 1, count); });
+			std::printf("%-8s %10llu %12.2f Gc/s %12.2f Gc/s %12.2f Gc/s %12.2f Gc/s\n", name, static_cast<unsigned long long>(count),
+						channel * 1e-9, food_channel * 1e-9, channel_16 * 1e-9, food_channel_16 * 1e-9);
+		}
+	}
+	return 0;
+}
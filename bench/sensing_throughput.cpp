@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "ant.hpp"
+#include "ant_soa.hpp"
+#include "ant_species.hpp"
+#include "marker_intensity_table.hpp"
+#include "number_generator.hpp"
+#include "simulation_context.hpp"
+#include "world.hpp"
+
+
+/**
+ * Samples per second of the sensing of the ants (Ant::findMarker: 32 samples within 40 px through the sensing
+ * table) with the row major and the tiled layouts of the grid, on 4K and 8K worlds covered with markers. The ants
+ * are scattered over the world and move between two rounds.
+ */
+
+// Drops the writes of the ants so both layouts sense the same field
+struct NullWriter
+{
+	void scaleMarker(const WorldCell&, Mode, float)
+	{}
+
+	void addMarker(sf::Vector2f, Mode, float)
+	{}
+};
+
+const uint32_t SAMPLES_PER_ANT = 32;
+
+// Millions of samples per second, best of a few repetitions
+double measure(uint32_t world_width, uint32_t world_height, uint32_t ants_count, GridLayout layout)
+{
+	World world(world_width, world_height, false, layout);
+	WorldGrid& grid = world.markers;
+	CounterRNG::setStream(1, 0, 0);
+	for (int32_t y(1); y < grid.height - 1; ++y) {
+		for (int32_t x(1); x < grid.width - 1; ++x) {
+			const uint64_t index = grid.getIndexFromCoords(sf::Vector2i(x, y));
+			grid.addMarker(index, Mode::ToFood, 10.0f * CounterRNG::nextFloat());
+			grid.addMarker(index, Mode::ToHome, 10.0f * CounterRNG::nextFloat());
+		}
+	}
+
+	const AntSpecies species;
+	const MarkerIntensityTable marker_intensities(species.marker_period);
+	AntSoA ants;
+	ants.reserve(ants_count);
+	for (uint32_t i(0); i < ants_count; ++i) {
+		const sf::Vector2f position(to<float>(world_width) * CounterRNG::nextFloat(), to<float>(world_height) * CounterRNG::nextFloat());
+		ants.add(position, 2.0f * PI * CounterRNG::nextFloat(), 0.0f, false, species);
+		ants.phase[i] = (i & 1) ? Mode::ToHome : Mode::ToFood;
+	}
+
+	const SimulationContext context;
+	NullWriter writer;
+	const float dt = 0.016f;
+	const uint32_t rounds = std::max(4u, (1u << 20) / ants_count);
+	uint64_t round = 0;
+	double best = 0.0;
+	for (uint32_t repetition(0); repetition < 3; ++repetition) {
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint32_t r(0); r < rounds; ++r, ++round) {
+			for (uint32_t i(0); i < ants_count; ++i) {
+				CounterRNG::setStream(1, i, round);
+				Ant ant(ants, i, species, marker_intensities);
+				ant.findMarker(world, writer, context, dt);
+				// A step forward, the ants leaving the world come back on the other side
+				sf::Vector2f& position = ants.position[i];
+				position += 2.0f * ants.direction[i].getTargetVec();
+				position.x = position.x < 0.0f ? position.x + world_width : (position.x >= world_width ? position.x - world_width : position.x);
+				position.y = position.y < 0.0f ? position.y + world_height : (position.y >= world_height ? position.y - world_height : position.y);
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = std::max(best, to<double>(ants_count) * rounds * SAMPLES_PER_ANT / seconds * 1e-6);
+	}
+	return best;
+}
+
+int main()
+{
+	const uint32_t sizes[][2] = { { 3840, 2160 }, { 7680, 4320 } };
+	const uint32_t ants_counts[] = { 16384, 131072 };
+	std::printf("%-12s %8s %18s %18s\n", "world (px)", "ants", "row major", "tiled");
+	for (const uint32_t* size : sizes) {
+		for (uint32_t ants_count : ants_counts) {
+			const double row_major = measure(size[0], size[1], ants_count, GridLayout::RowMajor);
+			const double tiled = measure(size[0], size[1], ants_count, GridLayout::Tiled);
+			std::printf("%5ux%-6u %8u %12.1f Ms/s %12.1f Ms/s\n", size[0], size[1], ants_count, row_major, tiled);
+		}
+	}
+	return 0;
+}
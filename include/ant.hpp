@@ -4,84 +4,107 @@
 #include "world.hpp"
 #include "config.hpp"
 #include "direction.hpp"
+#include "ant_soa.hpp"
+#include "ant_species.hpp"
+#include "sensing_table.hpp"
+#include "marker_intensity_table.hpp"
 #include "number_generator.hpp"
 #include "ant_mode.hpp"
+#include "simulation_context.hpp"
 
 #include <iostream>
 
 
+/**
+ * @brief View on one ant of an AntSoA
+ *
+ * Binds the fields of the ant so the behaviour reads like the one of a standalone object, views are cheap and
+ * meant to be created for each update.
+ */
 struct Ant
 {
-	Ant() = default;
+	/**
+	 * @brief Construct a view on an ant
+	 *
+	 * @param ants Storage of the colony
+	 * @param index Index of the ant in the storage
+	 * @param species_ Parameters shared by the ants of the colony
+	 * @param marker_intensities_ Intensities of the markers of the species
+	 */
+	Ant(AntSoA& ants, uint64_t index, const AntSpecies& species_, const MarkerIntensityTable& marker_intensities_)
+		: species(species_)
+		, marker_intensities(marker_intensities_)
+		, phase(ants.phase[index])
+		, position(ants.position[index])
+		, direction(ants.direction[index])
+		, hits(ants.hits[index])
+		, last_direction_update(ants.last_direction_update[index])
+		, markers_count(ants.markers_count[index])
+		, last_marker(ants.last_marker[index])
+		, liberty_coef(ants.liberty_coef[index])
+		, dilusion_counter(ants.dilusion_counter[index])
+		, trip_start(ants.trip_start[index])
+		, flags(ants.flags[index])
+		, is_malicious(flags & AntSoA::MALICIOUS)
+		, counter_pheromone(species.counter_pheromone && !is_malicious)
+	{
+	}
 
 	/**
-	 * @brief Construct a new Ant object
-	 * 
-	 * @param x Colony X position
-	 * @param y Colony Y position
-	 * @param angle Starting angle of the ant (wrt colony)
-	 * @param counter_pheromone_arg Will the ants secret counter pheromone?
-	 * @param malicious is the current ant malicious?
-	 * @param ant_tracing_pattern_arg Should malicious ants trace food pheromone or roam randomly
-	 * @param hell_phermn_intensity_multiplier_arg multiplier for the intensity of TO_HELL pheromone
+	 * @brief Move the ant and drop its markers, its timers have to be advanced with AntSoA::advanceTimers first
+	 *
+	 * @param world World the ant senses
+	 * @param writer Receives the writes of the ant, either the World itself or a WorldEditBuffer
 	 */
-	Ant(float x, float y, float angle, bool counter_pheromone_arg = false,
-		bool malicious=false, AntTracingPattern ant_tracing_pattern_arg = AntTracingPattern::RANDOM, float hell_phermn_intensity_multiplier_arg = 1.0)
-		: position(x, y)
-		, direction(angle)
-		, last_direction_update(RNGf::getUnder(1.0f) * direction_update_period)
-		, last_marker(RNGf::getUnder(1.0f) * marker_period)
-		, phase(Mode::ToFood)
-		, liberty_coef(RNGf::getRange(0.0001f, 0.001f))
-		, hits(0)
-		, markers_count(0.0f)
-	    , is_malicious(malicious)
-		, dilusion_counter(DILUSION_MAX)
-		, dilusion_patience_threshold(200)
-		, counter_thresh(850)
-		, ant_tracing_pattern(ant_tracing_pattern_arg)
-		, counter_pheromone(counter_pheromone_arg)
-		, hell_phermn_intensity_multiplier(hell_phermn_intensity_multiplier_arg)
+	template<typename TWriter>
+	void update(const float dt, const World& world, TWriter& writer, SimulationContext& context, bool wreak_havoc)
 	{
-		static bool mal_ant_counted;
-		if(is_malicious)
-			if(!mal_ant_counted)
-			{
-				mal_ant_counted = true;
-				first_mal_ant = true;
-			}
+		move(world, dt, wreak_havoc);
+		act(dt, world, writer, context, canPickFood(world));
 	}
 
-	void update(const float dt, World& world, bool wreak_havoc)
+	// First part of update, it neither draws random numbers nor writes
+	void move(const World& world, float dt, bool wreak_havoc)
 	{
 		updatePosition(world, dt);
 		if(is_malicious && wreak_havoc)
 		phase = Mode::ToHell;
+	}
+
+	bool canPickFood(const World& world) const
+	{
+		return phase == Mode::ToFood && world.markers.isOnFood(position);
+	}
 
-		if (phase == Mode::ToFood) {
-			checkFood(world);
+	/**
+	 * @brief Rest of update once the ant moved
+	 *
+	 * @param pick_food Take the food of the cell of the ant, false when the ants updated before it took it all
+	 */
+	template<typename TWriter>
+	void act(const float dt, const World& world, TWriter& writer, SimulationContext& context, bool pick_food)
+	{
+		if (pick_food) {
+			pickFood(writer, context);
 		}
 
-		last_direction_update += dt;
-		if (last_direction_update > direction_update_period) {
-			findMarker(world, dt);
-			direction += RNGf::getFullRange(direction_noise_range);
+		if (last_direction_update > species.direction_update_period) {
+			findMarker(world, writer, context, dt);
+			direction += RNGf::getFullRange(species.direction_noise_range);
 			last_direction_update = 0.0f;
 		}
 
-		last_marker += dt;
-		if (last_marker >= marker_period) {
-			addMarker(world);
+		if (last_marker >= species.marker_period) {
+			addMarker(writer);
 		}
 
 		direction.update(dt);	
 	}
 
-	void updatePosition(World& world, float dt)
+	void updatePosition(const World& world, float dt)
 	{
 		sf::Vector2f v = direction.getVec();
-		const sf::Vector2f next_position = position + (dt * move_speed) * v;
-		const HitPoint intersection = world.markers.getFirstHit(position, v, dt * move_speed);
+		const HitPoint intersection = world.markers.getFirstHit(position, v, dt * species.move_speed);
 		if (intersection.cell) {
 			++hits;
 			v.x *= intersection.normal.x ? -1.0f : 1.0f;
@@ -95,262 +118,229 @@ struct Ant
 		}
 		else {
 			hits = 0;
-			position += (dt * move_speed) * v;
+			position += (dt * species.move_speed) * v;
 			// Ants outside the map go back to home
 			position.x = (position.x < 0.0f || position.x > Conf::WIN_WIDTH) ? Conf::COLONY_POSITION.x : position.x;
 			position.y = (position.y < 0.0f || position.y > Conf::WIN_HEIGHT) ? Conf::COLONY_POSITION.y : position.y;
 		}
 	}
 
-	void checkFood(World& world)
-	{
-		if (world.markers.isOnFood(position)) {
-			phase = Mode::ToHome;
-			direction.addNow(PI);
-			world.markers.pickFood(position);
-			// if(!is_malicious) 
-				markers_count = 0.0f;
-			dilusion_counter = DILUSION_MAX;
-			food_bits_taken_counter++;
-			found_food = true;
-			return;
-		}
-	}
-
-	static int getFoodBitsTaken()
+	template<typename TWriter>
+	void pickFood(TWriter& writer, SimulationContext& context)
 	{
-		return food_bits_taken_counter;
+		phase = Mode::ToHome;
+		direction.addNow(PI);
+		writer.pickFood(position);
+		// if(!is_malicious) 
+			markers_count = 0.0f;
+		dilusion_counter = context.dilusion_max;
+		context.food_bits_taken++;
+		flags |= AntSoA::FOUND_FOOD;
 	}
 
-	static int getFoodBitsDelivered()
-	{
-		return food_bits_delivered_counter;
-	}
-
-	static void resetFoodBitsCounters()
-	{
-		food_bits_taken_counter = 0;
-		food_bits_delivered_counter = 0;
-	}
-
-	static void setDilusionMax(float max_value)
-	{
-		DILUSION_MAX = max_value;
-	}
-
-	static void setDilusionIncrement(float increment_value)
-	{
-		DILUSION_INCREMENT = increment_value;
-	}
-
-	void checkColony(const sf::Vector2f colony_position)
+	/**
+	 * @brief Deliver the food carried by the ant if it reached the colony
+	 *
+	 * @param step Current colony step, a delivery ends the round trip of the ant
+	 */
+	void checkColony(const sf::Vector2f colony_position, SimulationContext& context, uint32_t step)
 	{
-		if (getLength(position - colony_position) < colony_size) {
+		if (getLength(position - colony_position) < species.colony_size) {
 			if (phase == Mode::ToHome) {
 				phase = Mode::ToFood;
 				direction.addNow(PI);
-				food_bits_delivered_counter++;
-				delivered_food_home = true;
+				context.food_bits_delivered++;
+				context.trips_completed++;
+				context.trip_steps += step - trip_start;
+				trip_start = step;
+				flags |= AntSoA::DELIVERED_FOOD;
 			}
 			// if(!is_malicious)
 				markers_count = 0.0f;
 		}
 	}
 	bool nearColony(const sf::Vector2f colony_position, float atol = 15.0f){
-		if (getLength(position - colony_position) < colony_size + atol) {
+		if (getLength(position - colony_position) < species.colony_size + atol) {
 			if (phase == Mode::ToFood) {
 				return true;
 			}	
 		}
 		return false;
 	}
-	void findMarker(World& world, float dt)
+	template<typename TWriter>
+	void findMarker(const World& world, TWriter& writer, const SimulationContext& context, float dt)
 	{
-		// Init
-		const float sample_angle_range = PI * 0.8f;
-		const float current_angle = direction.getCurrentAngle();
-		float max_intensity = 0.0f;
-		sf::Vector2f max_direction;
-		WorldCell* max_cell = nullptr;
-		// Sample the world
+		const WorldGrid& grid = world.markers;
+		const SensingTable& table = SensingTable::get();
 		const uint32_t sample_count = 32;
-		bool on_food_path = false;
+		// Draw the samples: an angle bin, a distance and the liberty test of each sample, a liberty draw is only
+		// consumed when the sample is examined
+		float sample_bins[sample_count];
+		float sample_distances[sample_count];
+		float liberty_draws[sample_count];
+		RNGf::fillRange(sample_bins, sample_count, 0.0f, to<float>(SensingTable::SIZE));
+		RNGf::fillRange(sample_distances, sample_count, 0.0f, species.marker_detection_max_dist);
+		RNGf::peek(liberty_draws, sample_count);
+		// Locate the samples, the offsets rotate the current direction
+		const sf::Vector2f forward = direction.getTargetVec();
+		const float cell_size = to<float>(grid.cell_size);
+		sf::Vector2f to_marker[sample_count];
+		uint64_t indexes[sample_count];
+		bool valid[sample_count];
+		for (uint32_t i(0); i < sample_count; ++i) {
+			const uint32_t bin = to<uint32_t>(sample_bins[i]);
+			const float c = table.cos_offset[bin];
+			const float s = table.sin_offset[bin];
+			to_marker[i] = sf::Vector2f(forward.x * c - forward.y * s, forward.x * s + forward.y * c);
+			const sf::Vector2f sample = position + sample_distances[i] * to_marker[i];
+			const int32_t cell_x = to<int32_t>(sample.x / cell_size);
+			const int32_t cell_y = to<int32_t>(sample.y / cell_size);
+			valid[i] = cell_x > -1 && cell_x < grid.width && cell_y > -1 && cell_y < grid.height;
+			indexes[i] = valid[i] ? grid.getIndexFromCoords(sf::Vector2i(cell_x, cell_y)) : 0;
+		}
+		// Gather what the ant senses in each cell
+		const uint8_t phase_bit = WorldGrid::getModeBit(phase);
+		float intensities[sample_count];
+		bool on_permanent[sample_count];
+		for (uint32_t i(0); i < sample_count; ++i) {
+			on_permanent[i] = valid[i] && (grid.permanent[indexes[i]] & phase_bit);
+			intensities[i] = valid[i] ? getSensedIntensity(grid, indexes[i]) : 0.0f;
+		}
+		// Samples are examined from the last one, until food or colony is found or the ant chooses its own path
+		int32_t permanent_sample = -1;
+		int32_t last_examined = sample_count;
+		uint32_t liberty_draws_used = 0;
 		for (uint32_t i(sample_count); i--;) {
-			// Get random point in range
-			const float sample_angle = current_angle + RNGf::getRange(sample_angle_range);
-			const float distance = RNGf::getUnder(marker_detection_max_dist);
-			const sf::Vector2f to_marker(cos(sample_angle), sin(sample_angle));
-			auto* cell = world.markers.getSafe(position + distance * to_marker);
-			// Check cell
-			if (!cell) {
+			if (!valid[i]) {
 				continue;
 			}
-			// Check for food or colony
-			if (cell->permanent[static_cast<uint32_t>(phase)]) {
-				max_direction = to_marker;
+			if (on_permanent[i]) {
+				permanent_sample = i;
 				break;
 			}
-			// Check for the most intense marker
-			float intensity;
-			if(phase == Mode::ToHell)
-			{
-				float value_1, value_2;
-				if(ant_tracing_pattern == AntTracingPattern::RANDOM)
-				{
-					value_1 = 0;
-					value_2 = 0;
-				}
-				else if(ant_tracing_pattern == AntTracingPattern::FOOD)
-				{
-					value_1 = cell->intensity[static_cast<uint32_t>(Mode::ToFood)];
-					value_2 = cell->intensity[static_cast<uint32_t>(Mode::ToHell)];
-				}
-				else
-				{
-					value_1 = cell->intensity[static_cast<uint32_t>(Mode::ToHome)];
-					value_2 = 0;//cell->intensity[static_cast<uint32_t>(Mode::ToHell)];
-				}
-				intensity = std::max(value_1, value_2);
-			}
-			else if(phase == Mode::ToFood)
-			{
-				float temp_intensity = 0;
-				float value_1 = cell->intensity[static_cast<uint32_t>(Mode::ToFood)];
-				float value_2 = cell->intensity[static_cast<uint32_t>(Mode::ToHell)];
-				float ctr_phrmn_intns = cell->intensity[static_cast<uint32_t>(Mode::CounterPhr)];
-				temp_intensity = std::max(value_1, value_2);
-				// intensity = temp_intensity;
-				
-				if (ctr_phrmn_intns < temp_intensity)
-					intensity = temp_intensity;
-				else
-					intensity = 0;
-			}
-			else
-				intensity = cell->intensity[static_cast<uint32_t>(phase)];
-			
-			if (intensity > max_intensity) {
-				max_intensity = intensity;
-				max_direction = to_marker;
-				max_cell = cell;
-
-			}
-			// Randomly choose own path
-			if (RNGf::proba(liberty_coef)) {
+			last_examined = i;
+			if (liberty_draws[liberty_draws_used++] < liberty_coef) {
 				break;
 			}
 		}
+		RNGf::skip(liberty_draws_used);
+		// Most intense marker among the examined samples, the first one in examination order wins ties
+		float max_intensity = 0.0f;
+		int32_t max_sample = -1;
+		for (int32_t i(sample_count - 1); i >= last_examined; --i) {
+			const bool more_intense = intensities[i] > max_intensity;
+			max_intensity = more_intense ? intensities[i] : max_intensity;
+			max_sample = more_intense ? i : max_sample;
+		}
+		sf::Vector2f max_direction;
+		if (permanent_sample >= 0) {
+			max_direction = to_marker[permanent_sample];
+		}
+		else if (max_sample >= 0) {
+			max_direction = to_marker[max_sample];
+		}
+		const WorldCell max_cell = max_sample >= 0 ? WorldCell(grid, indexes[max_sample]) : WorldCell();
 		// Update direction
 		
 		if (max_intensity) {
 			if (RNGf::proba(0.4f) && (phase == Mode::ToFood)) {
-				max_cell->intensity[static_cast<uint32_t>(phase)] *= 0.99f;
+				writer.scaleMarker(max_cell, phase, 0.99f);
 				if (counter_pheromone)
 				{
 					// std::cout<<"Okay";
-					const float coef = 0.01f;
 					dilusion_counter = dilusion_counter > 0 ? dilusion_counter - 1.0f : 0;
-					const float intensity = 1000.0f * exp(-coef * (dilusion_counter));
-					world.addMarker(position, Mode::CounterPhr, intensity);
+					const float intensity = marker_intensities.getCounter(dilusion_counter);
+					writer.addMarker(position, Mode::CounterPhr, intensity);
 					// std::cout<<intensity<<" ";
 				}
 			}
-			direction = getAngle(max_direction);
+			direction.setTarget(max_direction);
 		}
 		else
-			// dilusion_counter = DILUSION_MAX;
-			dilusion_counter = std::min(DILUSION_MAX, dilusion_counter+DILUSION_INCREMENT);
+			// dilusion_counter = context.dilusion_max;
+			dilusion_counter = std::min(context.dilusion_max, dilusion_counter + context.dilusion_increment);
+	}
+
+	// Intensity of the markers the ant follows in a cell given its phase
+	float getSensedIntensity(const WorldGrid& grid, uint64_t index) const
+	{
+		if(phase == Mode::ToHell)
+		{
+			float value_1, value_2;
+			if(species.malicious_tracing_pattern == AntTracingPattern::RANDOM)
+			{
+				value_1 = 0;
+				value_2 = 0;
+			}
+			else if(species.malicious_tracing_pattern == AntTracingPattern::FOOD)
+			{
+				value_1 = grid.getIntensity(index, Mode::ToFood);
+				value_2 = grid.getIntensity(index, Mode::ToHell);
+			}
+			else
+			{
+				value_1 = grid.getIntensity(index, Mode::ToHome);
+				value_2 = 0;//grid.getIntensity(index, Mode::ToHell);
+			}
+			return std::max(value_1, value_2);
+		}
+		else if(phase == Mode::ToFood)
+		{
+			float value_1 = grid.getIntensity(index, Mode::ToFood);
+			float value_2 = grid.getIntensity(index, Mode::ToHell);
+			float ctr_phrmn_intns = grid.getIntensity(index, Mode::CounterPhr);
+			const float temp_intensity = std::max(value_1, value_2);
+			return ctr_phrmn_intns < temp_intensity ? temp_intensity : 0.0f;
+		}
+		return grid.getIntensity(index, phase);
 	}
 
-	void addMarker(World& world)
+	template<typename TWriter>
+	void addMarker(TWriter& writer)
 	{
-		markers_count += marker_period;
-		const float coef = 0.01f;
-		float intensity = 1000.0f * exp(-coef * markers_count);
+		markers_count += species.marker_period;
+		float intensity = marker_intensities.getMarker(markers_count);
 		Mode trace;
 		if(phase == Mode::ToHell)
 		{
 			trace = Mode::ToHell;
-			intensity *= hell_phermn_intensity_multiplier;
-			// if(first_mal_ant)
-			// 	std::cout<<markers_count<<"  ";
+			intensity *= species.hell_phermn_intensity_multiplier;
 			// intensity = 1000.0f * hell_phermn_intensity_multiplier;
 			// std::cout<<intensity<<"  ";
 		}
 		else 
 			trace = phase == Mode::ToFood ? Mode::ToHome : Mode::ToFood;
-		world.addMarker(position, trace, intensity);
+		writer.addMarker(position, trace, intensity);
 		// else
 		//   world.addMarker(position, Mode::ToFood, intensity);
 		last_marker = 0.0f;
 	}
 
-	void render_food(sf::RenderTarget& target, const sf::RenderStates& states) const
-	{
-		if (phase == Mode::ToHome) {
-			const float radius = 2.0f;
-			sf::CircleShape circle(radius);
-			circle.setOrigin(radius, radius);
-			circle.setPosition(position + length * 0.65f * direction.getVec());
-			circle.setFillColor(Conf::FOOD_COLOR);
-			target.draw(circle, states);
-		}
-	}
-
-	void render_in(sf::VertexArray& va, const uint32_t index) const
-	{
-		const sf::Vector2f dir_vec(direction.getVec());
-		const sf::Vector2f nrm_vec(-dir_vec.y, dir_vec.x);
-
-		va[index + 0].position = position - width * nrm_vec + length * dir_vec;
-		va[index + 1].position = position + width * nrm_vec + length * dir_vec;
-		va[index + 2].position = position + width * nrm_vec - length * dir_vec;
-		va[index + 3].position = position - width * nrm_vec - length * dir_vec;
-	}
-
-	bool didAntFindFood()
+	bool didAntFindFood() const
 	{
-		return found_food;
+		return flags & AntSoA::FOUND_FOOD;
 	}
 
-	bool didAntDeliverFood()
+	bool didAntDeliverFood() const
 	{
-		return delivered_food_home;
+		return flags & AntSoA::DELIVERED_FOOD;
 	}
 
-	// Parameters
-	const float width = 3.0f;
-	const float length = 4.7f;
-	const float move_speed = 50.0f;
-	const float marker_detection_max_dist = 40.0f;
-	const float direction_update_period = 0.125f;
-	const float marker_period = 0.125f;
-	const float direction_noise_range = PI * 0.1f;
-	const float colony_size = 20.0f;
+	const AntSpecies& species;
+	const MarkerIntensityTable& marker_intensities;
 
-	Mode phase;
-	sf::Vector2f position;
-	Direction direction;
-	uint32_t hits;
+	Mode& phase;
+	sf::Vector2f& position;
+	Direction& direction;
+	uint32_t& hits;
 
-	float last_direction_update;
-	float markers_count;
-	float last_marker;
-	float liberty_coef;
-	float dilusion_counter;
-	inline static float DILUSION_MAX;
-	float dilusion_patience_threshold;
-	float markers_count_dilusion;
-	float counter_thresh;
-	bool is_malicious;
-	bool malicious_ants_focus;
-	AntTracingPattern ant_tracing_pattern;
-	bool counter_pheromone;
-	float hell_phermn_intensity_multiplier;
-	inline static int food_bits_taken_counter;
-	inline static int food_bits_delivered_counter;
-	inline static float DILUSION_INCREMENT;
-	bool found_food = false;
-	bool delivered_food_home = false;
-	bool first_mal_ant = false;
+	float& last_direction_update;
+	float& markers_count;
+	float& last_marker;
+	float& liberty_coef;
+	float& dilusion_counter;
+	uint32_t& trip_start;
+	uint8_t& flags;
+	const bool is_malicious;
+	const bool counter_pheromone;
 };
@@ -2,7 +2,7 @@
 #include <cstdint>
 
 
-enum class Mode : uint32_t
+enum class Mode : uint8_t
 {
 	ToHome = 0,
 	ToFood = 1,
@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <SFML/System.hpp>
+
+#include "ant_mode.hpp"
+#include "ant_species.hpp"
+#include "direction.hpp"
+#include "grid.hpp"
+#include "number_generator.hpp"
+
+
+/**
+ * @brief State of the ants of a colony, one array per field
+ *
+ * Parameters common to all ants live in the AntSpecies of the colony, Ant gives an object view of one index.
+ * The arrays can be reordered, an ant is identified by its id, its index at creation.
+ */
+struct AntSoA
+{
+	enum Flag : uint8_t
+	{
+		MALICIOUS = 1,
+		FOUND_FOOD = 2,
+		DELIVERED_FOOD = 4
+	};
+
+	std::vector<sf::Vector2f> position;
+	std::vector<Direction> direction;
+	std::vector<Mode> phase;
+	std::vector<uint32_t> hits;
+	// Timers
+	std::vector<float> last_direction_update;
+	std::vector<float> last_marker;
+	std::vector<float> markers_count;
+	// Probability to stop sampling and keep its own path
+	std::vector<float> liberty_coef;
+	// Counter pheromone dilusion counter
+	std::vector<float> dilusion_counter;
+	// Step at which the current round trip started
+	std::vector<uint32_t> trip_start;
+	std::vector<uint8_t> flags;
+	// Index of the ant at creation, keys its random streams
+	std::vector<uint32_t> id;
+
+	// Fields of one ant but its id, to restore it
+	struct State
+	{
+		sf::Vector2f position;
+		Direction direction;
+		Mode phase;
+		uint32_t hits;
+		float last_direction_update;
+		float last_marker;
+		float markers_count;
+		float liberty_coef;
+		float dilusion_counter;
+		uint32_t trip_start;
+		uint8_t flags;
+	};
+
+	uint64_t size() const
+	{
+		return position.size();
+	}
+
+	void reserve(uint64_t n)
+	{
+		position.reserve(n);
+		direction.reserve(n);
+		phase.reserve(n);
+		hits.reserve(n);
+		last_direction_update.reserve(n);
+		last_marker.reserve(n);
+		markers_count.reserve(n);
+		liberty_coef.reserve(n);
+		dilusion_counter.reserve(n);
+		trip_start.reserve(n);
+		flags.reserve(n);
+		id.reserve(n);
+	}
+
+	/**
+	 * @brief Add an ant, its timers and liberty coefficient are drawn from the current random stream
+	 *
+	 * @param pos Starting position of the ant
+	 * @param angle Starting angle of the ant (wrt colony)
+	 * @param dilusion_max Starting value of the counter pheromone dilusion counter
+	 * @param malicious is the ant malicious?
+	 */
+	void add(sf::Vector2f pos, float angle, float dilusion_max, bool malicious, const AntSpecies& species)
+	{
+		position.push_back(pos);
+		direction.emplace_back(angle);
+		phase.push_back(Mode::ToFood);
+		hits.push_back(0);
+		last_direction_update.push_back(RNGf::getUnder(1.0f) * species.direction_update_period);
+		markers_count.push_back(0.0f);
+		last_marker.push_back(RNGf::getUnder(1.0f) * species.marker_period);
+		liberty_coef.push_back(RNGf::getRange(0.0001f, 0.001f));
+		dilusion_counter.push_back(dilusion_max);
+		trip_start.push_back(0);
+		flags.push_back(malicious ? MALICIOUS : 0);
+		id.push_back(to<uint32_t>(id.size()));
+	}
+
+	State getState(uint64_t i) const
+	{
+		return {position[i], direction[i], phase[i], hits[i], last_direction_update[i], last_marker[i], markers_count[i], liberty_coef[i],
+				dilusion_counter[i], trip_start[i], flags[i]};
+	}
+
+	void setState(uint64_t i, const State& state)
+	{
+		position[i] = state.position;
+		direction[i] = state.direction;
+		phase[i] = state.phase;
+		hits[i] = state.hits;
+		last_direction_update[i] = state.last_direction_update;
+		last_marker[i] = state.last_marker;
+		markers_count[i] = state.markers_count;
+		liberty_coef[i] = state.liberty_coef;
+		dilusion_counter[i] = state.dilusion_counter;
+		trip_start[i] = state.trip_start;
+		flags[i] = state.flags;
+	}
+
+	bool hasFlag(uint64_t i, Flag flag) const
+	{
+		return flags[i] & flag;
+	}
+
+	void setFlag(uint64_t i, Flag flag)
+	{
+		flags[i] |= flag;
+	}
+
+	// Advance the timers of all the ants
+	void advanceTimers(float dt)
+	{
+		const uint64_t count = size();
+		for (uint64_t i(0); i < count; ++i) {
+			last_direction_update[i] += dt;
+			last_marker[i] += dt;
+		}
+	}
+
+	/**
+	 * @brief Reorder the ants along a Z-order curve of their cell
+	 *
+	 * Ants updated one after the other then read and write neighbouring parts of the grid.
+	 * Ants of a same cell are kept in the order of their ids.
+	 */
+	void sortByCell(const GridGeometry& grid)
+	{
+		const uint64_t count = size();
+		// Curve position in the high bits, id in the low bits
+		std::vector<uint64_t> keys(count);
+		std::vector<uint32_t> index_of_id(count);
+		for (uint64_t i(0); i < count; ++i) {
+			const sf::Vector2i cell = grid.getCellCoords(position[i]);
+			const uint64_t curve_key = getCurveKey(to<uint32_t>(std::max(0, cell.x)), to<uint32_t>(std::max(0, cell.y)));
+			keys[i] = (curve_key << 32) | id[i];
+			index_of_id[id[i]] = to<uint32_t>(i);
+		}
+		std::sort(keys.begin(), keys.end());
+		std::vector<uint32_t> order(count);
+		for (uint64_t i(0); i < count; ++i) {
+			order[i] = index_of_id[keys[i] & 0xFFFFFFFFu];
+		}
+		permute(order);
+	}
+
+	// Put the ants back in the order of their ids
+	void sortById()
+	{
+		const uint64_t count = size();
+		std::vector<uint32_t> order(count);
+		for (uint64_t i(0); i < count; ++i) {
+			order[id[i]] = to<uint32_t>(i);
+		}
+		permute(order);
+	}
+
+private:
+	// Interleave the bits of cell coordinates below 2^16
+	static uint32_t getCurveKey(uint32_t x, uint32_t y)
+	{
+		return spreadBits(x) | (spreadBits(y) << 1);
+	}
+
+	static uint32_t spreadBits(uint32_t v)
+	{
+		v &= 0xFFFFu;
+		v = (v | (v << 8)) & 0x00FF00FFu;
+		v = (v | (v << 4)) & 0x0F0F0F0Fu;
+		v = (v | (v << 2)) & 0x33333333u;
+		v = (v | (v << 1)) & 0x55555555u;
+		return v;
+	}
+
+	// Index i receives the ant that was at index order[i]
+	void permute(const std::vector<uint32_t>& order)
+	{
+		permuteArray(position, order);
+		permuteArray(direction, order);
+		permuteArray(phase, order);
+		permuteArray(hits, order);
+		permuteArray(last_direction_update, order);
+		permuteArray(last_marker, order);
+		permuteArray(markers_count, order);
+		permuteArray(liberty_coef, order);
+		permuteArray(dilusion_counter, order);
+		permuteArray(trip_start, order);
+		permuteArray(flags, order);
+		permuteArray(id, order);
+	}
+
+	template<typename T>
+	static void permuteArray(std::vector<T>& values, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> permuted;
+		permuted.reserve(values.size());
+		for (uint32_t index : order) {
+			permuted.push_back(values[index]);
+		}
+		values.swap(permuted);
+	}
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include "utils.hpp"
+#include "ant_mode.hpp"
+
+
+/**
+ * @brief Parameters shared by all the ants of a colony
+ */
+struct AntSpecies
+{
+	// Body size, only used for rendering
+	float width = 3.0f;
+	float length = 4.7f;
+
+	float move_speed = 50.0f;
+	float marker_detection_max_dist = 40.0f;
+	float direction_update_period = 0.125f;
+	float marker_period = 0.125f;
+	float direction_noise_range = PI * 0.1f;
+	float colony_size = 20.0f;
+
+	// Will the non malicious ants secret counter pheromone?
+	bool counter_pheromone = false;
+	// Should malicious ants trace food pheromone or roam randomly
+	AntTracingPattern malicious_tracing_pattern = AntTracingPattern::RANDOM;
+	// Multiplier for the intensity of the TO_HELL pheromone of malicious ants
+	float hell_phermn_intensity_multiplier = 1.0f;
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <SFML/Graphics.hpp>
 #include "double_buffer.hpp"
 
@@ -10,11 +12,12 @@ struct AsyncRenderer
 	DoubleObject<sf::VertexArray>& vertex_array;
 	std::thread thread;
 	std::mutex mutex;
-	bool run;
+	std::atomic<bool> run;
 
 	AsyncRenderer(DoubleObject<sf::VertexArray>& target)
 		: vertex_array(target)
 		, run(true)
+		, update_requested(false)
 	{}
 
 	// To be overloaded
@@ -29,21 +32,56 @@ struct AsyncRenderer
 		thread = std::thread([this]() {update(); });
 	}
 
+	// Update the vertex array once more, typically after it was drawn
+	void requestUpdate()
+	{
+		{
+			std::lock_guard<std::mutex> lock(request_mutex);
+			update_requested = true;
+		}
+		update_request.notify_one();
+	}
+
+	// Has to be called by derived classes owning the vertex array before it is destroyed
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(request_mutex);
+			run = false;
+		}
+		update_request.notify_one();
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+
 	virtual ~AsyncRenderer()
 	{
-		run = false;
-		thread.join();
+		stop();
 	}
 
 private:
+	std::mutex request_mutex;
+	std::condition_variable update_request;
+	bool update_requested;
+
 	void update()
 	{
-		while (run) {
+		while (waitUpdateRequest()) {
 			updateVertexArray();
 			trySwap();
 		}
 	}
 
+	// False once stopped
+	bool waitUpdateRequest()
+	{
+		std::unique_lock<std::mutex> lock(request_mutex);
+		update_request.wait(lock, [this]() { return !run || update_requested; });
+		update_requested = false;
+		return run;
+	}
+
 	void trySwap()
 	{
 		if (mutex.try_lock()) {
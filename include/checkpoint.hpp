@@ -0,0 +1,372 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "world.hpp"
+#include "colony.hpp"
+#include "simulation_context.hpp"
+#include "results_file.hpp"
+
+
+/**
+ * @brief Binary snapshot of a trial: World, Colony, counters and the series recorded so far
+ *
+ * The random numbers are keyed by (seed, ant index, step) so the seed of the context and the step of the colony
+ * are the whole RNG state. Parameters of the run (species, evaporation, patience, ...) aren't stored, they are
+ * those of the configuration that loads the checkpoint, which is what allows forking variants of a warmed up run.
+ *
+ * The layout is the native one of the machine, a checkpoint is meant to be read by the build that wrote it.
+ */
+namespace Checkpoint
+{
+	const char MAGIC[8] = {'A', 'N', 'T', 'S', 'I', 'M', 'C', '\0'};
+	const uint32_t VERSION = 4;
+
+	class Writer
+	{
+	public:
+		Writer()
+		{
+			appendBytes(MAGIC, sizeof(MAGIC));
+			write(VERSION);
+		}
+
+		template<typename T>
+		void write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written");
+			appendBytes(&value, sizeof(T));
+		}
+
+		template<typename T>
+		void write(const std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written");
+			write(static_cast<uint64_t>(values.size()));
+			appendBytes(values.data(), values.size() * sizeof(T));
+		}
+
+		void write(const std::string& str)
+		{
+			write(static_cast<uint64_t>(str.size()));
+			appendBytes(str.data(), str.size());
+		}
+
+		// Written to a temporary file renamed once complete, an interrupted save keeps the previous checkpoint
+		void save(const std::string& path) const
+		{
+			const std::string tmp_path = path + ".tmp";
+			std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+			if (!file) {
+				throw std::runtime_error("Cannot create checkpoint " + tmp_path);
+			}
+			const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+			if (std::fclose(file) || !written || std::rename(tmp_path.c_str(), path.c_str())) {
+				throw std::runtime_error("Cannot write checkpoint " + path);
+			}
+		}
+
+	private:
+		std::vector<char> data;
+
+		void appendBytes(const void* bytes, uint64_t size)
+		{
+			const char* begin = static_cast<const char*>(bytes);
+			data.insert(data.end(), begin, begin + size);
+		}
+	};
+
+	class Reader
+	{
+	public:
+		// Throws if the file can't be read or isn't a checkpoint
+		explicit Reader(const std::string& path)
+			: cursor(0)
+		{
+			std::FILE* file = std::fopen(path.c_str(), "rb");
+			if (!file) {
+				throw std::runtime_error("Cannot open checkpoint " + path);
+			}
+			char buffer[4096];
+			uint64_t count;
+			while ((count = std::fread(buffer, 1, sizeof(buffer), file))) {
+				data.insert(data.end(), buffer, buffer + count);
+			}
+			std::fclose(file);
+
+			char magic[sizeof(MAGIC)];
+			readBytes(magic, sizeof(magic));
+			if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) || read<uint32_t>() != VERSION) {
+				throw std::runtime_error(path + " is not a checkpoint of this version");
+			}
+		}
+
+		template<typename T>
+		T read()
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+			T value;
+			readBytes(&value, sizeof(T));
+			return value;
+		}
+
+		template<typename T>
+		void read(T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+			readBytes(&value, sizeof(T));
+		}
+
+		template<typename T>
+		void read(std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+			const uint64_t size = read<uint64_t>();
+			if (size > (data.size() - cursor) / sizeof(T)) {
+				throw std::runtime_error("Truncated checkpoint");
+			}
+			values.resize(size);
+			readBytes(values.data(), size * sizeof(T));
+		}
+
+		void read(std::string& str)
+		{
+			const uint64_t size = read<uint64_t>();
+			if (size > data.size() - cursor) {
+				throw std::runtime_error("Truncated checkpoint");
+			}
+			str.assign(data.data() + cursor, size);
+			cursor += size;
+		}
+
+		// Read a vector that must keep its size, e.g. a plane of a grid of known dimensions
+		template<typename T>
+		void readSized(std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+			if (read<uint64_t>() != values.size()) {
+				throw std::runtime_error("Checkpoint doesn't match the simulated world or colony");
+			}
+			readBytes(values.data(), values.size() * sizeof(T));
+		}
+
+	private:
+		std::vector<char> data;
+		uint64_t cursor;
+
+		void readBytes(void* out, uint64_t size)
+		{
+			if (size > data.size() - cursor) {
+				throw std::runtime_error("Truncated checkpoint");
+			}
+			std::memcpy(out, data.data() + cursor, size);
+			cursor += size;
+		}
+	};
+
+	inline void write(Writer& out, const SimulationContext& context)
+	{
+		out.write(context.seed);
+		out.write(context.food_bits_taken);
+		out.write(context.food_bits_delivered);
+		out.write(context.ants_that_found_food);
+		out.write(context.ants_that_delivered_food);
+		out.write(context.ants_per_phase);
+		out.write(context.trips_completed);
+		out.write(context.trip_steps);
+	}
+
+	inline void read(Reader& in, SimulationContext& context)
+	{
+		in.read(context.seed);
+		in.read(context.food_bits_taken);
+		in.read(context.food_bits_delivered);
+		in.read(context.ants_that_found_food);
+		in.read(context.ants_that_delivered_food);
+		in.read(context.ants_per_phase);
+		in.read(context.trips_completed);
+		in.read(context.trip_steps);
+	}
+
+	inline void write(Writer& out, const WorldGrid& grid)
+	{
+		out.write(grid.width);
+		out.write(grid.height);
+		out.write(grid.layout);
+		out.write(static_cast<uint32_t>(sizeof(IntensityStorage::Value)));
+		for (const std::vector<IntensityStorage::Value>& plane : grid.intensity) {
+			out.write(plane);
+		}
+		out.write(grid.permanent);
+		out.write(grid.food);
+		out.write(grid.wall);
+		// Lazy decay state, the intensities are only meaningful with it
+		out.write(grid.lazy_decay);
+		out.write(grid.last_update);
+		out.write(grid.current_step);
+		out.write(grid.decay_rate);
+		out.write(grid.decay_carry);
+	}
+
+	inline void read(Reader& in, WorldGrid& grid)
+	{
+		if (in.read<int32_t>() != grid.width || in.read<int32_t>() != grid.height) {
+			throw std::runtime_error("Checkpoint doesn't match the size of the world");
+		}
+		if (in.read<GridLayout>() != grid.layout) {
+			throw std::runtime_error("Checkpoint was written with another grid_layout setting");
+		}
+		if (in.read<uint32_t>() != sizeof(IntensityStorage::Value)) {
+			throw std::runtime_error("Checkpoint was written by a build with another intensity storage");
+		}
+		for (std::vector<IntensityStorage::Value>& plane : grid.intensity) {
+			in.readSized(plane);
+		}
+		in.readSized(grid.permanent);
+		in.readSized(grid.food);
+		in.readSized(grid.wall);
+		if (in.read<bool>() != grid.lazy_decay) {
+			throw std::runtime_error("Checkpoint was written with another lazy_decay setting");
+		}
+		in.readSized(grid.last_update);
+		in.read(grid.current_step);
+		in.read(grid.decay_rate);
+		in.read(grid.decay_carry);
+		grid.updateActiveTiles();
+		grid.updateWallDistance();
+	}
+
+	inline void write(Writer& out, const AntSoA& ants)
+	{
+		out.write(ants.position);
+		out.write(ants.direction);
+		out.write(ants.phase);
+		out.write(ants.hits);
+		out.write(ants.last_direction_update);
+		out.write(ants.last_marker);
+		out.write(ants.markers_count);
+		out.write(ants.liberty_coef);
+		out.write(ants.dilusion_counter);
+		out.write(ants.trip_start);
+		out.write(ants.flags);
+	}
+
+	inline void read(Reader& in, AntSoA& ants)
+	{
+		in.readSized(ants.position);
+		in.readSized(ants.direction);
+		in.readSized(ants.phase);
+		in.readSized(ants.hits);
+		in.readSized(ants.last_direction_update);
+		in.readSized(ants.last_marker);
+		in.readSized(ants.markers_count);
+		in.readSized(ants.liberty_coef);
+		in.readSized(ants.dilusion_counter);
+		in.readSized(ants.trip_start);
+		in.readSized(ants.flags);
+		for (uint64_t i(0); i < ants.size(); ++i) {
+			ants.id[i] = to<uint32_t>(i);
+		}
+	}
+
+	inline void write(Writer& out, const Colony& colony)
+	{
+		out.write(colony.step);
+		out.write(colony.last_direction_update);
+		out.write(colony.timer_count);
+		out.write(colony.timer_count2);
+		out.write(colony.confused_count);
+		out.write(colony.skip_once);
+		// Stored in id order, the order of the ants doesn't change the outcome of the step synchronous update
+		AntSoA ants = colony.ants;
+		ants.sortById();
+		write(out, ants);
+	}
+
+	inline void read(Reader& in, Colony& colony)
+	{
+		in.read(colony.step);
+		in.read(colony.last_direction_update);
+		in.read(colony.timer_count);
+		in.read(colony.timer_count2);
+		in.read(colony.confused_count);
+		in.read(colony.skip_once);
+		read(in, colony.ants);
+	}
+
+	inline double getRecordPeriod(const RunSeries& run)
+	{
+		for (const RunSeries::Parameter& parameter : run.parameters) {
+			if (parameter.name == "record_period") {
+				return parameter.value;
+			}
+		}
+		return 0.0;
+	}
+
+	inline void write(Writer& out, const RunSeries& run)
+	{
+		out.write(getRecordPeriod(run));
+		out.write(static_cast<uint64_t>(run.columns.size()));
+		for (uint64_t i(0); i < run.columns.size(); ++i) {
+			out.write(run.column_names[i]);
+			out.write(run.columns[i]);
+		}
+	}
+
+	// The columns and the sampling period of the checkpoint must be the ones of the run
+	inline void read(Reader& in, RunSeries& run)
+	{
+		if (in.read<double>() != getRecordPeriod(run)) {
+			throw std::runtime_error("Checkpoint was recorded with another metrics interval");
+		}
+		if (in.read<uint64_t>() != run.columns.size()) {
+			throw std::runtime_error("Checkpoint was recorded with other metrics");
+		}
+		for (uint64_t i(0); i < run.columns.size(); ++i) {
+			std::string name;
+			in.read(name);
+			if (name != run.column_names[i]) {
+				throw std::runtime_error("Checkpoint was recorded with other metrics");
+			}
+			in.read(run.columns[i]);
+		}
+	}
+
+	/**
+	 * @brief Save the state of a trial
+	 *
+	 * @param next_step Index of the first step that isn't simulated yet
+	 */
+	inline void save(const std::string& path, const World& world, const Colony& colony, const SimulationContext& context, const RunSeries& run, uint64_t next_step)
+	{
+		Writer out;
+		out.write(next_step);
+		write(out, context);
+		write(out, world.markers);
+		write(out, colony);
+		write(out, run);
+		out.save(path);
+	}
+
+	/**
+	 * @brief Restore the state of a trial, World and Colony must have been built with the same sizes
+	 *
+	 * @return Index of the first step that isn't simulated yet
+	 */
+	inline uint64_t load(const std::string& path, World& world, Colony& colony, SimulationContext& context, RunSeries& run)
+	{
+		Reader in(path);
+		const uint64_t next_step = in.read<uint64_t>();
+		read(in, context);
+		read(in, world.markers);
+		read(in, colony);
+		read(in, run);
+		return next_step;
+	}
+}
@@ -1,10 +1,15 @@
 #pragma once
-#include <SFML/Graphics.hpp>
+#include <SFML/System.hpp>
+#include <algorithm>
 #include <vector>
 #include <list>
+#include <map>
 #include "ant.hpp"
 #include "utils.hpp"
 #include "world.hpp"
+#include "world_edit_buffer.hpp"
+#include "worker_pool.hpp"
+#include "simulation_context.hpp"
 
 
 struct Colony
@@ -15,6 +20,7 @@ struct Colony
    * @param x Colony X position
    * @param y Colony Y position
    * @param n Colony Number of ants
+   * @param context Parameters of the simulation run
    * @param mal_prob Probability of an ant being malicious (fraction of ants being malicious)
    * @param mal_timer_delay Delay after which the attack is launched
    * @param malicious_ants_focus  Should the attack be focused towards food
@@ -22,12 +28,12 @@ struct Colony
 	 * @param counter_pheromone Will the ants secret counter pheromone?
 	 * @param hell_phermn_intensity_multiplier multiplier for the intensity of TO_HELL pheromone
    */
-	Colony(float x, float y, uint32_t n, float mal_prob, int mal_timer_delay, bool malicious_ants_focus = true, 
+	Colony(float x, float y, uint32_t n, const SimulationContext& context, float mal_prob, int mal_timer_delay, bool malicious_ants_focus = true, 
           AntTracingPattern ant_tracing_pattern = AntTracingPattern::RANDOM, bool counter_pheromone = false,
           float hell_phermn_intensity_multiplier = 1.0)
 		: position(x, y)
+		, marker_intensities(species.marker_period)
 		, last_direction_update(0.0f)
-		, ants_va(sf::Quads, 4 * n)
     , mal_timer_delay(mal_timer_delay)
     , timer_count(0)
     , timer_count2(0)
@@ -36,21 +42,16 @@ struct Colony
     // std::cout<<std::abs(((double) rand() / (RAND_MAX)));
       // std::cout<<"Normal";
 
+    species.counter_pheromone = counter_pheromone;
+    species.malicious_tracing_pattern = ant_tracing_pattern;
+    species.hell_phermn_intensity_multiplier = hell_phermn_intensity_multiplier;
+    ants.reserve(n);
     for (uint64_t i(0); i < n; ++i) {
+      // Step 0 stream: initial state of the ant
+      CounterRNG::setStream(context.seed, i, step);
       if(i >= mal_prob*n)
       {
-        ants.emplace_back(x, y, getRandRange(2.0f * PI), counter_pheromone);
-
-        const uint64_t index = 4 * i;
-        ants_va[index + 0].color = Conf::ANT_COLOR;
-        ants_va[index + 1].color = Conf::ANT_COLOR;
-        ants_va[index + 2].color = Conf::ANT_COLOR;
-        ants_va[index + 3].color = Conf::ANT_COLOR;
-
-        ants_va[index + 0].texCoords = sf::Vector2f(0.0f, 0.0f);
-        ants_va[index + 1].texCoords = sf::Vector2f(73.0f, 0.0f);
-        ants_va[index + 2].texCoords = sf::Vector2f(73.0f, 107.0f);
-        ants_va[index + 3].texCoords = sf::Vector2f(0.0f, 107.0f);
+        ants.add(position, getRandRange(2.0f * PI), context.dilusion_max, false, species);
       }
       else
       {
@@ -61,37 +62,222 @@ struct Colony
           else
             angle = getRandRange(2.0f * PI); // Sets even distribution
 
-          ants.emplace_back(x, y, angle, false, true, ant_tracing_pattern, hell_phermn_intensity_multiplier); 
-
-          const uint64_t index = 4 * i;
-          ants_va[index + 0].color = Conf::MALICIOUS_ANT_COLOR;
-          ants_va[index + 1].color = Conf::MALICIOUS_ANT_COLOR;
-          ants_va[index + 2].color = Conf::MALICIOUS_ANT_COLOR;
-          ants_va[index + 3].color = Conf::MALICIOUS_ANT_COLOR;
-
-          ants_va[index + 0].texCoords = sf::Vector2f(0.0f, 0.0f);
-          ants_va[index + 1].texCoords = sf::Vector2f(73.0f, 0.0f);
-          ants_va[index + 2].texCoords = sf::Vector2f(73.0f, 107.0f);
-          ants_va[index + 3].texCoords = sf::Vector2f(0.0f, 107.0f);
+          ants.add(position, angle, context.dilusion_max, true, species);
 		  }
     }
 	}
 
-	void update(const float dt, World& world)
-	{	
+	/**
+	 * @brief Update all the ants
+	 *
+	 * Without a pool the ants are updated one after the other and each one sees the writes of the previous ones.
+	 * With a pool the ants are split in contiguous ranges updated concurrently, they all read the field of the
+	 * previous step and their writes are buffered then applied in ant order, so the outcome doesn't depend on
+	 * the number of threads. Ants finding food that the ants before them took in the same step are updated
+	 * again without it, see settleFoodClaims.
+	 *
+	 * With a sort period the step synchronous update also sorts the ants by cell every sort_period steps.
+	 * The ants keep their random streams and their writes are applied in the order of their ids, the outcome
+	 * doesn't depend on the sort either. The sequential update never sorts: each ant sees the writes of the ants
+	 * updated before it, so a new order would change what the ants read and with it the results.
+	 *
+	 * @param pool Workers used for the step synchronous update, nullptr for the sequential one
+	 */
+	void update(const float dt, World& world, SimulationContext& context, WorkerPool* pool = nullptr)
+	{
+    if (pool) {
+      updateBuffered(dt, world, context, *pool);
+      return;
+    }
     confused_count = 0;
-    ants_that_found_food = 0; 
-    ants_that_delivered_food = 0;
+    context.ants_that_found_food = 0;
+    context.ants_that_delivered_food = 0;
+    context.resetPhaseCounters();
     bool wreak_havoc = timer_count >= mal_timer_delay ? true : false;
-		for (Ant& ant : ants) {
+    ++step;
+    ants.advanceTimers(dt);
+		for (uint64_t i(0); i < ants.size(); ++i) {
+      Ant ant(ants, i, species, marker_intensities);
+      CounterRNG::setStream(context.seed, ants.id[i], step);
       if(!skip_once)
-			  ant.checkColony(position);
-			ant.update(dt, world, wreak_havoc);
-      if(ant.didAntFindFood())
-        ants_that_found_food++;
-      if(ant.didAntDeliverFood())
-        ants_that_delivered_food++;
+			  ant.checkColony(position, context, to<uint32_t>(step));
+			ant.update(dt, world, world, context, wreak_havoc);
+      countAnt(ant, context);
 		}
+    endStep(wreak_havoc);
+	}
+
+	void updateBuffered(const float dt, World& world, SimulationContext& context, WorkerPool& pool)
+	{
+    confused_count = 0;
+    context.ants_that_found_food = 0;
+    context.ants_that_delivered_food = 0;
+    context.resetPhaseCounters();
+    const bool wreak_havoc = timer_count >= mal_timer_delay;
+    if (sort_period && step % sort_period == 0) {
+      ants.sortByCell(world.markers);
+    }
+    ++step;
+    ants.advanceTimers(dt);
+    const uint32_t group_count = pool.getThreadCount();
+    // One buffer per group and one for the ants updated again by settleFoodClaims
+    if (edit_buffers.size() != group_count + 1) {
+      edit_buffers.clear();
+      for (uint32_t i(0); i <= group_count; ++i) {
+        edit_buffers.emplace_back(world);
+      }
+      group_contexts.resize(group_count);
+      food_claims.resize(group_count);
+    }
+    const uint64_t ants_count = ants.size();
+    edit_spans.resize(sort_period ? ants_count : 0);
+    for (uint32_t g(0); g < group_count; ++g) {
+      pool.addJob([&, g]() {
+        WorldEditBuffer& buffer = edit_buffers[g];
+        SimulationContext& group_context = group_contexts[g];
+        buffer.clear();
+        food_claims[g].clear();
+        group_context = context;
+        group_context.resetCounters();
+        const uint64_t begin = (ants_count * g) / group_count;
+        const uint64_t end = (ants_count * (g + 1)) / group_count;
+        for (uint64_t i(begin); i < end; ++i) {
+          Ant ant(ants, i, species, marker_intensities);
+          const uint32_t id = ants.id[i];
+          const uint64_t edits_begin = buffer.edits.size();
+          CounterRNG::setStream(context.seed, id, step);
+          if(!skip_once)
+            ant.checkColony(position, group_context, to<uint32_t>(step));
+          ant.move(world, dt, wreak_havoc);
+          if (ant.canPickFood(world)) {
+            // The counters of the ant are only added once the food of the cell is settled
+            FoodClaim claim = {to<uint32_t>(i), to<uint32_t>(edits_begin), 0, world.markers.getIndex(ant.position), ants.getState(i), group_context, false, 0, 0};
+            claim.counters.resetCounters();
+            ant.act(dt, world, buffer, claim.counters, true);
+            countAnt(ant, claim.counters);
+            claim.edits_end = to<uint32_t>(buffer.edits.size());
+            food_claims[g].push_back(claim);
+          }
+          else {
+            ant.act(dt, world, buffer, group_context, false);
+            countAnt(ant, group_context);
+          }
+          if (sort_period) {
+            edit_spans[id] = {g, to<uint32_t>(edits_begin), to<uint32_t>(buffer.edits.size())};
+          }
+        }
+      });
+    }
+    pool.waitForCompletion();
+    settleFoodClaims(dt, world, context);
+    if (sort_period) {
+      // Sorted ants aren't in the order of their ids, their writes are replayed one ant at a time
+      for (const EditSpan& span : edit_spans) {
+        edit_buffers[span.buffer].apply(world, span.begin, span.end);
+      }
+    }
+    else {
+      // Groups cover consecutive ant ranges, applying them in order replays the writes in ant order. The writes
+      // of the ants updated again replace their first ones
+      const WorldEditBuffer& settled = edit_buffers[group_count];
+      for (uint32_t g(0); g < group_count; ++g) {
+        uint64_t applied = 0;
+        for (const FoodClaim& claim : food_claims[g]) {
+          if (claim.denied) {
+            edit_buffers[g].apply(world, applied, claim.edits_begin);
+            settled.apply(world, claim.settled_begin, claim.settled_end);
+            applied = claim.edits_end;
+          }
+        }
+        edit_buffers[g].apply(world, applied, edit_buffers[g].edits.size());
+      }
+    }
+    for (uint32_t g(0); g < group_count; ++g) {
+      context.addCounters(group_contexts[g]);
+    }
+    endStep(wreak_havoc);
+	}
+
+	/**
+	 * @brief Give the food of the cells to the ants in id order, as the sequential update does
+	 *
+	 * The ants of a step synchronous update all read the food of the previous step, so several of them can take
+	 * the last food of a cell. The ants finding it already taken by the ants before them are put back as they were
+	 * after moving and updated again without food. Their random streams start over, they draw the numbers they
+	 * would have drawn.
+	 */
+	void settleFoodClaims(const float dt, const World& world, SimulationContext& context)
+	{
+    std::vector<FoodClaim*> claims;
+    for (std::vector<FoodClaim>& group_claims : food_claims) {
+      for (FoodClaim& claim : group_claims) {
+        claims.push_back(&claim);
+      }
+    }
+    std::sort(claims.begin(), claims.end(), [this](const FoodClaim* a, const FoodClaim* b) { return ants.id[a->index] < ants.id[b->index]; });
+    WorldEditBuffer& settled = edit_buffers.back();
+    settled.clear();
+    std::map<uint64_t, uint32_t> taken;
+    for (FoodClaim* claim : claims) {
+      if (++taken[claim->cell] <= world.markers.food[claim->cell]) {
+        context.addCounters(claim->counters);
+        continue;
+      }
+      claim->denied = true;
+      ants.setState(claim->index, claim->state);
+      Ant ant(ants, claim->index, species, marker_intensities);
+      const uint32_t id = ants.id[claim->index];
+      CounterRNG::setStream(context.seed, id, step);
+      SimulationContext counters = context;
+      counters.resetCounters();
+      claim->settled_begin = to<uint32_t>(settled.edits.size());
+      ant.act(dt, world, settled, counters, false);
+      countAnt(ant, counters);
+      claim->settled_end = to<uint32_t>(settled.edits.size());
+      context.addCounters(counters);
+      if (sort_period) {
+        edit_spans[id] = {to<uint32_t>(edit_buffers.size() - 1), claim->settled_begin, claim->settled_end};
+      }
+    }
+	}
+
+	// Per step counters of an updated ant
+	static void countAnt(const Ant& ant, SimulationContext& counters)
+	{
+    if(ant.didAntFindFood())
+      counters.ants_that_found_food++;
+    if(ant.didAntDeliverFood())
+      counters.ants_that_delivered_food++;
+    counters.ants_per_phase[to<uint32_t>(ant.phase)]++;
+	}
+
+	/**
+	 * @brief Choose the malicious ants again, with the rule of the constructor
+	 *
+	 * Used when a run is forked with another malicious fraction, the ants keep their state except for the
+	 * former malicious ants that go back to looking for food.
+	 *
+	 * @param mal_prob Fraction of ants being malicious
+	 */
+	void setMaliciousFraction(float mal_prob)
+	{
+    const uint64_t n = ants.size();
+    for (uint64_t i(0); i < n; ++i) {
+      const bool malicious = !(ants.id[i] >= mal_prob*n);
+      if (malicious) {
+        ants.setFlag(i, AntSoA::MALICIOUS);
+      }
+      else {
+        ants.flags[i] &= ~AntSoA::MALICIOUS;
+        if (ants.phase[i] == Mode::ToHell) {
+          ants.phase[i] = Mode::ToFood;
+        }
+      }
+    }
+	}
+
+	void endStep(bool wreak_havoc)
+	{
     skip_once = false;
     if(wreak_havoc)
     {
@@ -102,35 +288,10 @@ struct Colony
     timer_count2 ++;
 	}
 
-  static int getAntsThatFoundFood()
-  {
-    return ants_that_found_food;
-  }
-
-  static int getAntsThatDeliveredFood()
-  {
-    return ants_that_delivered_food;
-  }
-
-	void render(sf::RenderTarget& target, const sf::RenderStates& states) const
-	{
-		for (const Ant& a : ants) {
-			a.render_food(target, states);
-		}
-
-		uint32_t index = 0;
-		for (const Ant& a : ants) {
-			a.render_in(ants_va, 4 * (index++));
-		}
-
-		sf::RenderStates rs = states;
-		rs.texture = &(*Conf::ANT_TEXTURE);
-		target.draw(ants_va, rs);
-	}
-
 	const sf::Vector2f position;
-	std::vector<Ant> ants;
-	mutable sf::VertexArray ants_va;
+	AntSpecies species;
+	MarkerIntensityTable marker_intensities;
+	AntSoA ants;
 	const float size = 20.0f;
 
 	float last_direction_update;
@@ -142,7 +303,42 @@ struct Colony
   int confused_count;
   float counter_rise_fraction;
   bool skip_once = true;
+  // Number of updates, selects the random stream of the ants with their index
+  uint64_t step = 0;
+
+  // Step synchronous update: steps between two sorts of the ants by cell, 0 to keep them in id order
+  uint32_t sort_period = 0;
+
+  // Step synchronous update: pending writes and counters of each ant range
+  std::vector<WorldEditBuffer> edit_buffers;
+  std::vector<SimulationContext> group_contexts;
 
-  inline static int ants_that_found_food;
-  inline static int ants_that_delivered_food;
+  // Writes of an ant in the edit buffers
+  struct EditSpan
+  {
+    uint32_t buffer;
+    uint32_t begin;
+    uint32_t end;
+  };
+  // Sorted ants: writes of each ant, by id
+  std::vector<EditSpan> edit_spans;
+
+  // Step synchronous update: an ant that took food, the ants before it may have taken the last of the cell
+  struct FoodClaim
+  {
+    uint32_t index;
+    // Writes of the ant in the buffer of its group
+    uint32_t edits_begin;
+    uint32_t edits_end;
+    uint64_t cell;
+    // The ant after moving, before it took the food
+    AntSoA::State state;
+    SimulationContext counters;
+    // Updated again without the food, its writes are then in the last edit buffer
+    bool denied;
+    uint32_t settled_begin;
+    uint32_t settled_end;
+  };
+  // Food claims of each ant range, in ant order
+  std::vector<std::vector<FoodClaim>> food_claims;
 };
@@ -0,0 +1,74 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "colony.hpp"
+#include "config.hpp"
+
+
+struct ColonyRenderer
+{
+	const Colony& colony;
+	sf::VertexArray ants_va;
+
+	ColonyRenderer(const Colony& colony_)
+		: colony(colony_)
+		, ants_va(sf::Quads, 4 * colony_.ants.size())
+	{
+		for (uint64_t i(0); i < colony.ants.size(); ++i) {
+			const sf::Color color = colony.ants.hasFlag(i, AntSoA::MALICIOUS) ? Conf::MALICIOUS_ANT_COLOR : Conf::ANT_COLOR;
+			const uint64_t index = 4 * i;
+			ants_va[index + 0].color = color;
+			ants_va[index + 1].color = color;
+			ants_va[index + 2].color = color;
+			ants_va[index + 3].color = color;
+
+			ants_va[index + 0].texCoords = sf::Vector2f(0.0f, 0.0f);
+			ants_va[index + 1].texCoords = sf::Vector2f(73.0f, 0.0f);
+			ants_va[index + 2].texCoords = sf::Vector2f(73.0f, 107.0f);
+			ants_va[index + 3].texCoords = sf::Vector2f(0.0f, 107.0f);
+		}
+	}
+
+	void render(sf::RenderTarget& target, const sf::RenderStates& states)
+	{
+		const uint64_t ants_count = colony.ants.size();
+		for (uint64_t i(0); i < ants_count; ++i) {
+			renderFood(i, target, states);
+		}
+
+		for (uint64_t i(0); i < ants_count; ++i) {
+			renderAnt(i, 4 * i);
+		}
+
+		sf::RenderStates rs = states;
+		rs.texture = &(*Conf::ANT_TEXTURE);
+		target.draw(ants_va, rs);
+	}
+
+private:
+	void renderFood(uint64_t ant, sf::RenderTarget& target, const sf::RenderStates& states) const
+	{
+		const AntSoA& ants = colony.ants;
+		if (ants.phase[ant] == Mode::ToHome) {
+			const float radius = 2.0f;
+			sf::CircleShape circle(radius);
+			circle.setOrigin(radius, radius);
+			circle.setPosition(ants.position[ant] + colony.species.length * 0.65f * ants.direction[ant].getVec());
+			circle.setFillColor(Conf::FOOD_COLOR);
+			target.draw(circle, states);
+		}
+	}
+
+	void renderAnt(uint64_t ant, const uint64_t index)
+	{
+		const sf::Vector2f position = colony.ants.position[ant];
+		const float width = colony.species.width;
+		const float length = colony.species.length;
+		const sf::Vector2f dir_vec(colony.ants.direction[ant].getVec());
+		const sf::Vector2f nrm_vec(-dir_vec.y, dir_vec.x);
+
+		ants_va[index + 0].position = position - width * nrm_vec + length * dir_vec;
+		ants_va[index + 1].position = position + width * nrm_vec + length * dir_vec;
+		ants_va[index + 2].position = position + width * nrm_vec - length * dir_vec;
+		ants_va[index + 3].position = position - width * nrm_vec - length * dir_vec;
+	}
+};
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <memory>
+#include <SFML/System.hpp>
+#ifndef ANTSIM_HEADLESS
 #include <SFML/Graphics.hpp>
+#endif
 
 
 template<typename T>
 struct DefaultConf
 {
+#ifndef ANTSIM_HEADLESS
 	const static sf::Color ANT_COLOR;
 	const static sf::Color MALICIOUS_ANT_COLOR;
 	const static sf::Color FOOD_COLOR;
@@ -16,13 +20,14 @@ struct DefaultConf
 	const static sf::Color COUNTER_PHR_COLOR;
 	const static sf::Color COLONY_COLOR;
 	const static sf::Color WALL_COLOR;
+#endif
 	static float COLONY_SIZE;
 	static sf::Vector2f COLONY_POSITION;
 	static uint32_t WIN_WIDTH;
 	static uint32_t WIN_HEIGHT;
 	static uint32_t WORLD_WIDTH;
 	static uint32_t WORLD_HEIGHT;
-	static uint32_t ANTS_COUNT;
+#ifndef ANTSIM_HEADLESS
 	static std::shared_ptr<sf::Texture> ANT_TEXTURE;
 	static std::shared_ptr<sf::Texture> MARKER_TEXTURE;
 
@@ -41,8 +46,10 @@ struct DefaultConf
 		DefaultConf::ANT_TEXTURE = nullptr;
 		DefaultConf::MARKER_TEXTURE = nullptr;
 	}
+#endif
 };
 
+#ifndef ANTSIM_HEADLESS
 template<typename T>
 const sf::Color DefaultConf<T>::ANT_COLOR = sf::Color(68, 73, 255);
 template<typename T>
@@ -61,6 +68,7 @@ template<typename T>
 const sf::Color DefaultConf<T>::COLONY_COLOR = DefaultConf<T>::ANT_COLOR;
 template<typename T>
 const sf::Color DefaultConf<T>::WALL_COLOR = sf::Color(94, 87, 87);
+#endif
 template<typename T>
 uint32_t DefaultConf<T>::WIN_WIDTH = 1920;
 template<typename T>
@@ -69,19 +77,16 @@ template<typename T>
 uint32_t DefaultConf<T>::WORLD_WIDTH = 1920;
 template<typename T>
 uint32_t DefaultConf<T>::WORLD_HEIGHT = 1080;
-
-//////////////////
-/// ANT NUMBER ///
-template<typename T>
-uint32_t DefaultConf<T>::ANTS_COUNT = 1024;
 template<typename T>
 float DefaultConf<T>::COLONY_SIZE = 20.0f;
 template<typename T>
 sf::Vector2f DefaultConf<T>::COLONY_POSITION = sf::Vector2f(DefaultConf<T>::WIN_WIDTH * 0.5f, DefaultConf<T>::WIN_HEIGHT * 0.5f);
 
+#ifndef ANTSIM_HEADLESS
 template<typename T>
 std::shared_ptr<sf::Texture> DefaultConf<T>::ANT_TEXTURE;
 template<typename T>
 std::shared_ptr<sf::Texture> DefaultConf<T>::MARKER_TEXTURE;
+#endif
 
 using Conf = DefaultConf<int>;
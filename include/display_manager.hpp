@@ -3,12 +3,15 @@
 #include <SFML/Graphics.hpp>
 #include "world.hpp"
 #include "colony.hpp"
+#include "field_renderer.hpp"
+#include "colony_renderer.hpp"
 
 
 class DisplayManager
 {
 public:
-    DisplayManager(sf::RenderTarget& target, sf::RenderWindow& window, World& world, Colony& colony);
+    DisplayManager(sf::RenderTarget& target, sf::RenderWindow& window, World& world, Colony& colony,
+                   FieldRenderer& world_renderer, ColonyRenderer& colony_renderer);
 
     //offset mutators
     void setOffset(float x, float y) {m_offsetX=x; m_offsetY=y;};
@@ -38,6 +41,7 @@ public:
 	bool pause;
 	bool update;
 	float render_time;
+	// Fast forward: the simulation runs as many steps as it can between two frames
 	bool speed_mode;
 	bool debug_mode;
 	bool wall_mode;
@@ -56,6 +60,8 @@ private:
 
 	World& m_world;
 	Colony& m_colony;
+	FieldRenderer& m_world_renderer;
+	ColonyRenderer& m_colony_renderer;
 
 	bool m_mouse_button_pressed;
 	sf::Vector2i m_drag_clic_position, m_clic_position;
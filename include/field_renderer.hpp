@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <SFML/Graphics.hpp>
+#include "config.hpp"
+#include "world_grid.hpp"
+
+
+/**
+ * @brief Draws the cells of the WorldGrid: markers, food and walls
+ *
+ * The renderers read the grid on a background thread while the simulation updates it on its own, they hold the
+ * lock of the simulation state while they read a part of the grid.
+ */
+struct FieldRenderer
+{
+	// Locks the state of the simulation that updates the grid
+	using StateLock = std::function<std::unique_lock<std::mutex>()>;
+
+	// Toggled by the display while the background thread reads it
+	std::atomic<bool> draw_markers;
+
+	// Without a state lock the grid must not change while the renderer exists
+	explicit FieldRenderer(StateLock lock_state_ = StateLock())
+		: draw_markers(true)
+		, lock_state(lock_state_)
+	{
+		// In the order of Mode
+		const sf::Color colors[WorldGrid::MODE_COUNT] = { Conf::TO_HOME_COLOR, Conf::TO_FOOD_COLOR, Conf::TO_HELL_COLOR, Conf::COUNTER_PHR_COLOR };
+		for (uint32_t i(0); i < WorldGrid::MODE_COUNT; ++i) {
+			const float intensity_factor = 0.27f / 255.0f;
+			marker_colors[i] = intensity_factor * sf::Vector3f(colors[i].r, colors[i].g, colors[i].b);
+		}
+	}
+
+	virtual ~FieldRenderer()
+	{}
+
+	virtual void render(sf::RenderTarget& target, sf::RenderStates states) = 0;
+
+	// Colour of a cell, food and walls hide the markers
+	sf::Color getCellColor(const WorldCell& cell) const
+	{
+		if (cell.getFood()) {
+			return Conf::FOOD_COLOR;
+		}
+		if (cell.isWall()) {
+			return Conf::WALL_COLOR;
+		}
+		// Cells of the inactive tiles hold no marker
+		if (!draw_markers || !cell.grid->isActive(cell.index)) {
+			return sf::Color::Black;
+		}
+		return getMarkerColor(cell);
+	}
+
+	// Sum of the colours of the markers of a cell weighted by their intensities
+	sf::Color getMarkerColor(const WorldCell& cell) const
+	{
+		sf::Vector3f mixed_color;
+		for (uint32_t i(0); i < WorldGrid::MODE_COUNT; ++i) {
+			mixed_color = mixed_color + cell.getIntensity(static_cast<Mode>(i)) * marker_colors[i];
+		}
+		return sf::Color(to<uint8_t>(std::min(255.0f, mixed_color.x)), to<uint8_t>(std::min(255.0f, mixed_color.y)), to<uint8_t>(std::min(255.0f, mixed_color.z)));
+	}
+
+protected:
+	std::unique_lock<std::mutex> lockState() const
+	{
+		return lock_state ? lock_state() : std::unique_lock<std::mutex>();
+	}
+
+private:
+	const StateLock lock_state;
+	// Colour of a unit of intensity of each Mode
+	sf::Vector3f marker_colors[WorldGrid::MODE_COUNT];
+};
@@ -0,0 +1,170 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "field_renderer.hpp"
+
+
+/**
+ * @brief Draws the field as a texture with one pixel per cell, scaled to the world
+ *
+ * A background thread colours the cells into a pixel buffer band of rows by band of rows and publishes the bands
+ * that changed. The render only uploads these bands to the texture and draws a single quad, the cost of a frame
+ * follows the area where the markers evolve instead of the size of the world.
+ *
+ * Each frame drawn requests the next pass of the thread, which reads each band with the simulation state locked.
+ * A pass is skipped when neither the version of the state nor the display of the markers changed since the
+ * previous one, a paused simulation costs no pass.
+ */
+struct FieldTextureRenderer : public FieldRenderer
+{
+	static constexpr int32_t BAND_ROWS = 16;
+
+	// Changes whenever the state of the simulation does
+	using StateVersion = std::function<uint64_t()>;
+
+	const WorldGrid& grid;
+
+	/**
+	 * @brief Throws if the grid is larger than the textures of the GPU
+	 *
+	 * @param state_version_ Without it every pass colours the cells
+	 */
+	explicit FieldTextureRenderer(const WorldGrid& grid_, StateLock lock_state_ = StateLock(), StateVersion state_version_ = StateVersion())
+		: FieldRenderer(lock_state_)
+		, grid(grid_)
+		, state_version(state_version_)
+		, band_count((grid_.height + BAND_ROWS - 1) / BAND_ROWS)
+		, pixels(getPixelCount() * 4, 0)
+		, published_pixels(pixels)
+		, dirty_bands(band_count, 1)
+		, run(true)
+		, pass_requested(true)
+	{
+		const uint32_t max_size = sf::Texture::getMaximumSize();
+		if (to<uint32_t>(grid.width) > max_size || to<uint32_t>(grid.height) > max_size || !texture.create(grid.width, grid.height)) {
+			throw std::runtime_error("The world is too large for the textures of this GPU, use the vertices field renderer");
+		}
+		texture.setSmooth(false);
+		sprite.setTexture(texture);
+		sprite.setScale(to<float>(grid.cell_size), to<float>(grid.cell_size));
+		thread = std::thread([this]() { update(); });
+	}
+
+	~FieldTextureRenderer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(request_mutex);
+			run = false;
+		}
+		pass_request.notify_one();
+		thread.join();
+	}
+
+	void render(sf::RenderTarget& target, sf::RenderStates states) override
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (int32_t band(0); band < band_count; ++band) {
+				if (dirty_bands[band]) {
+					const int32_t y = band * BAND_ROWS;
+					const int32_t rows = std::min(BAND_ROWS, grid.height - y);
+					texture.update(&published_pixels[getPixelIndex(y)], grid.width, rows, 0, y);
+					dirty_bands[band] = 0;
+				}
+			}
+		}
+		target.draw(sprite, states);
+		{
+			std::lock_guard<std::mutex> lock(request_mutex);
+			pass_requested = true;
+		}
+		pass_request.notify_one();
+	}
+
+private:
+	const StateVersion state_version;
+	const int32_t band_count;
+	// Colours of the cells as of the latest pass of the background thread, RGBA row by row
+	std::vector<sf::Uint8> pixels;
+	// Copy of pixels read by the render, bands are copied as they change
+	std::vector<sf::Uint8> published_pixels;
+	// Bands of published_pixels the texture doesn't have yet
+	std::vector<uint8_t> dirty_bands;
+	std::mutex mutex;
+	sf::Texture texture;
+	sf::Sprite sprite;
+	std::atomic<bool> run;
+	// Set by the render, the thread waits for it between two passes
+	std::mutex request_mutex;
+	std::condition_variable pass_request;
+	bool pass_requested;
+	std::thread thread;
+
+	uint64_t getPixelCount() const
+	{
+		return to<uint64_t>(grid.width) * to<uint64_t>(grid.height);
+	}
+
+	uint64_t getPixelIndex(int32_t y) const
+	{
+		return to<uint64_t>(y) * to<uint64_t>(grid.width) * 4;
+	}
+
+	void update()
+	{
+		std::vector<sf::Uint8> band_pixels(to<uint64_t>(BAND_ROWS) * to<uint64_t>(grid.width) * 4);
+		bool colored = false;
+		uint64_t colored_version = 0;
+		bool colored_markers = false;
+		while (waitPassRequest()) {
+			// Read before the pass, a step during the pass changes it for the next one
+			const uint64_t version = state_version ? state_version() : 0;
+			const bool markers = draw_markers;
+			if (colored && state_version && version == colored_version && markers == colored_markers) {
+				continue;
+			}
+			colored = true;
+			colored_version = version;
+			colored_markers = markers;
+			for (int32_t band(0); band < band_count; ++band) {
+				const int32_t y_begin = band * BAND_ROWS;
+				const int32_t y_end = std::min(y_begin + BAND_ROWS, grid.height);
+				uint64_t i = 0;
+				{
+					std::unique_lock<std::mutex> state_lock = lockState();
+					for (int32_t y(y_begin); y < y_end; ++y) {
+						for (int32_t x(0); x < grid.width; ++x) {
+							const sf::Color color = getCellColor(WorldCell(grid, grid.getIndexFromCoords(sf::Vector2i(x, y))));
+							band_pixels[i++] = color.r;
+							band_pixels[i++] = color.g;
+							band_pixels[i++] = color.b;
+							band_pixels[i++] = color.a;
+						}
+					}
+				}
+				sf::Uint8* band_begin = &pixels[getPixelIndex(y_begin)];
+				if (std::memcmp(band_begin, band_pixels.data(), i)) {
+					std::memcpy(band_begin, band_pixels.data(), i);
+					std::lock_guard<std::mutex> lock(mutex);
+					std::memcpy(&published_pixels[getPixelIndex(y_begin)], band_begin, i);
+					dirty_bands[band] = 1;
+				}
+			}
+		}
+	}
+
+	// False once the renderer is destroyed
+	bool waitPassRequest()
+	{
+		std::unique_lock<std::mutex> lock(request_mutex);
+		pass_request.wait(lock, [this]() { return !run || pass_requested; });
+		pass_requested = false;
+		return run;
+	}
+};
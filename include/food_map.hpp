@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+/**
+ * @brief Pixels of the food map image
+ *
+ * GUI builds decode the image with SFML. Headless builds only link SFML System
+ * and decode uncompressed BMP files (8, 24 or 32 bits per pixel) themselves.
+ */
+struct FoodMap
+{
+	struct Pixel
+	{
+		uint8_t r, g, b;
+	};
+
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<Pixel> pixels;
+
+	bool loadFromFile(const std::string& path);
+
+	Pixel getPixel(uint32_t x, uint32_t y) const
+	{
+		return pixels[x + y * width];
+	}
+};
@@ -2,53 +2,56 @@
 #include <vector>
 #include <list>
 #include <SFML/System.hpp>
+#include "utils.hpp"
 
 
-template<typename T>
-struct Grid
+// Order of the cells in the storage of a grid
+enum class GridLayout : uint8_t
 {
-	std::vector<T> cells;
+	RowMajor,
+	// Square tiles of GridGeometry::TILE_SIZE cells stored one after the other, the tiles and the cells of a tile
+	// in row major order. Neighbouring cells share cache lines and pages in both directions.
+	Tiled
+};
+
+
+// Cell coordinates and indexing shared by every grid
+struct GridGeometry
+{
+	static constexpr int32_t TILE_SHIFT = 4;
+	static constexpr int32_t TILE_SIZE = 1 << TILE_SHIFT;
 
 	const int32_t width, height, cell_size;
+	const GridLayout layout;
+	// Tiled layout: tiles in a row of tiles, the last ones are padded
+	const int32_t tile_row_size;
 
-	Grid(int32_t width_, int32_t height_, uint32_t cell_size_)
+	GridGeometry(int32_t width_, int32_t height_, uint32_t cell_size_, GridLayout layout_ = GridLayout::RowMajor)
 		: cell_size(cell_size_)
 		, width(width_ / cell_size_)
 		, height(height_ / cell_size_)
+		, layout(layout_)
+		, tile_row_size((width + TILE_SIZE - 1) >> TILE_SHIFT)
 	{
-		cells.resize(width * height);
-	}
-
-	T* getSafe(sf::Vector2f pos)
-	{
-		sf::Vector2i cell_coords = getCellCoords(pos);
-		if (checkCoords(cell_coords)) {
-			return &get(cell_coords);
-		}
-		return nullptr;
 	}
 
-	const T& getCst(sf::Vector2i cell_coord) const
+	// Number of cells in the grid
+	uint64_t getCellCount() const
 	{
-		return cells[getIndexFromCoords(cell_coord)];
+		return static_cast<uint64_t>(width) * height;
 	}
 
-	const T& getCst(sf::Vector2f position) const
+	// Number of elements of the storage, with the padding of the tiled layout
+	uint64_t getStorageSize() const
 	{
-		return getCst(getCellCoords(position));
-	}
-
-	T& get(sf::Vector2f position)
-	{
-		return const_cast<T&>(getCst(position));
-	}
-
-	T& get(sf::Vector2i cell_coord)
-	{
-		return const_cast<T&>(getCst(cell_coord));
+		if (layout == GridLayout::RowMajor) {
+			return getCellCount();
+		}
+		const uint64_t tile_column_size = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+		return static_cast<uint64_t>(tile_row_size) * tile_column_size * TILE_SIZE * TILE_SIZE;
 	}
 
-	sf::Vector2f getCellCenter(sf::Vector2f position)
+	sf::Vector2f getCellCenter(sf::Vector2f position) const
 	{
 		const sf::Vector2i cell_coords = getCellCoords(position);
 		return float(cell_size) * sf::Vector2f(cell_coords.x + 0.5f, cell_coords.y + 0.5f);
@@ -64,9 +67,15 @@ struct Grid
 		return cell_coords.x > -1 && cell_coords.x < width && cell_coords.y > -1 && cell_coords.y < height;
 	}
 
+	// Coordinates must be valid
 	uint64_t getIndexFromCoords(const sf::Vector2i& cell_coords) const
 	{
-		return cell_coords.x + cell_coords.y * width;
+		if (layout == GridLayout::RowMajor) {
+			return cell_coords.x + cell_coords.y * width;
+		}
+		const uint64_t tile = static_cast<uint64_t>(cell_coords.y >> TILE_SHIFT) * tile_row_size + (cell_coords.x >> TILE_SHIFT);
+		const uint64_t cell = ((cell_coords.y & (TILE_SIZE - 1)) << TILE_SHIFT) | (cell_coords.x & (TILE_SIZE - 1));
+		return (tile << (2 * TILE_SHIFT)) | cell;
 	}
 
 	sf::Vector2i getCellCoords(const sf::Vector2f& position) const
@@ -77,3 +86,45 @@ struct Grid
 		return sf::Vector2i(x_cell, y_cell);
 	}
 };
+
+
+template<typename T>
+struct Grid : public GridGeometry
+{
+	std::vector<T> cells;
+
+	Grid(int32_t width_, int32_t height_, uint32_t cell_size_, GridLayout layout_ = GridLayout::RowMajor)
+		: GridGeometry(width_, height_, cell_size_, layout_)
+	{
+		cells.resize(getStorageSize());
+	}
+
+	T* getSafe(sf::Vector2f pos)
+	{
+		sf::Vector2i cell_coords = getCellCoords(pos);
+		if (checkCoords(cell_coords)) {
+			return &get(cell_coords);
+		}
+		return nullptr;
+	}
+
+	const T& getCst(sf::Vector2i cell_coord) const
+	{
+		return cells[getIndexFromCoords(cell_coord)];
+	}
+
+	const T& getCst(sf::Vector2f position) const
+	{
+		return getCst(getCellCoords(position));
+	}
+
+	T& get(sf::Vector2f position)
+	{
+		return const_cast<T&>(getCst(position));
+	}
+
+	T& get(sf::Vector2i cell_coord)
+	{
+		return const_cast<T&>(getCst(cell_coord));
+	}
+};
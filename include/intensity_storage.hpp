@@ -0,0 +1,80 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+/**
+ * @brief Type of the values of the WorldGrid intensity planes
+ *
+ * float by default. Building with ANTSIM_FIXED_INTENSITY stores them as 16 bits fixed point with a resolution of
+ * 1/32, which halves the size of the planes. Values saturate at 2047.97 and the evaporation subtracts whole units:
+ * the fraction of a unit a step doesn't remove is carried over to the next steps, so the average rate is exact.
+ */
+namespace IntensityStorage
+{
+#ifdef ANTSIM_FIXED_INTENSITY
+	using Value = uint16_t;
+	// Intensity removed from the cells at a step
+	using Decay = uint16_t;
+
+	const float UNITS_PER_INTENSITY = 32.0f;
+	const float MAX_UNITS = 65535.0f;
+
+	// Rounded to the nearest unit, saturating
+	inline Value encode(float intensity)
+	{
+		const float units = std::min(std::max(intensity * UNITS_PER_INTENSITY + 0.5f, 0.0f), MAX_UNITS);
+		return static_cast<Value>(units);
+	}
+
+	inline float decode(Value value)
+	{
+		return static_cast<float>(value) * (1.0f / UNITS_PER_INTENSITY);
+	}
+
+	/**
+	 * @brief Whole units removed at this step
+	 *
+	 * @param carry Fraction of a unit left by the previous steps, updated
+	 */
+	inline Decay getDecay(float rate, double& carry)
+	{
+		const double units = std::min(double(rate) * UNITS_PER_INTENSITY + carry, double(MAX_UNITS));
+		const double whole = std::floor(units);
+		carry = units - whole;
+		return static_cast<Decay>(whole);
+	}
+
+	inline uint32_t getBits(Value value)
+	{
+		return value;
+	}
+#else
+	using Value = float;
+	using Decay = float;
+
+	inline Value encode(float intensity)
+	{
+		return intensity;
+	}
+
+	inline float decode(Value value)
+	{
+		return value;
+	}
+
+	inline Decay getDecay(float rate, double&)
+	{
+		return rate;
+	}
+
+	inline uint32_t getBits(Value value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+#endif
+}
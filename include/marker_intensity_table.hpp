@@ -0,0 +1,67 @@
+#pragma once
+#include <cmath>
+#include "utils.hpp"
+
+
+/**
+ * @brief Intensities of the markers the ants drop, read from tables
+ *
+ * markers_count only grows by marker_period from 0 and the dilusion counter of the counter pheromone moves by
+ * whole units, so both intensities come from small sets of values. The tables hold them for the first SIZE
+ * values, computed with the same expression as the exact computation, which gives the same bits. Values outside
+ * the tables are computed.
+ */
+struct MarkerIntensityTable
+{
+	static constexpr uint32_t SIZE = 4096;
+	static constexpr float COEF = 0.01f;
+
+	// Compute every intensity instead of reading the tables, to validate them
+	bool exact;
+
+	explicit MarkerIntensityTable(float marker_period)
+		: exact(false)
+	{
+		// Accumulated like the markers_count of the ants
+		float count = 0.0f;
+		for (uint32_t i(0); i < SIZE; ++i) {
+			marker_counts[i] = count;
+			marker[i] = compute(count);
+			counter[i] = compute(to<float>(i));
+			count += marker_period;
+		}
+	}
+
+	// Intensity of a marker dropped after value steps of dilution
+	static float compute(float value)
+	{
+		return 1000.0f * exp(-COEF * value);
+	}
+
+	// Intensity of a marker given the markers_count of the ant that drops it
+	float getMarker(float count) const
+	{
+		const float marker_period = marker_counts[1];
+		const uint32_t i = count >= 0.0f && count < marker_counts[SIZE - 1] ? to<uint32_t>(count / marker_period + 0.5f) : SIZE;
+		if (!exact && i < SIZE && marker_counts[i] == count) {
+			return marker[i];
+		}
+		return compute(count);
+	}
+
+	// Intensity of a counter pheromone marker given the dilusion counter of the ant that drops it
+	float getCounter(float dilusion_counter) const
+	{
+		const uint32_t i = dilusion_counter >= 0.0f && dilusion_counter < to<float>(SIZE) ? to<uint32_t>(dilusion_counter) : SIZE;
+		if (!exact && i < SIZE && to<float>(i) == dilusion_counter) {
+			return counter[i];
+		}
+		return compute(dilusion_counter);
+	}
+
+private:
+	// markers_count of the ants after each drop, the index of their intensity
+	float marker_counts[SIZE];
+	float marker[SIZE];
+	float counter[SIZE];
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ant_mode.hpp"
+#include "simulation_context.hpp"
+#include "results_file.hpp"
+#include "world_grid.hpp"
+
+
+/**
+ * @brief Quantities that can be sampled during a run
+ *
+ * Ant metrics come from the counters the colony keeps up to date in the SimulationContext, field metrics from
+ * the FieldStats WorldGrid::update computes on the sampling steps.
+ */
+enum class Metric : uint8_t
+{
+	FoodFoundPerAnt,
+	FoodDeliveredPerAnt,
+	FractionFoundFood,
+	FractionDeliveredFood,
+	AntsToFood,
+	AntsToHome,
+	AntsToHell,
+	MeanTripLength,
+	MassToHome,
+	MassToFood,
+	MassToHell,
+	MassCounter,
+	MaliciousTrailCoverage,
+	Count
+};
+
+
+/**
+ * @brief Turns the state of a run into the rows of its RunSeries
+ */
+struct MetricSampler
+{
+	// Sampled metrics, in column order
+	std::vector<Metric> metrics;
+	// Steps between two samples
+	uint32_t interval;
+
+	MetricSampler()
+		: interval(1)
+	{}
+
+	// Name of the column of a metric, also its name in the configuration
+	static const char* getName(Metric metric)
+	{
+		static const char* names[] = {
+			"food_found_per_ant",
+			"food_delivered_per_ant",
+			"fraction_of_ants_found_food",
+			"fraction_of_ants_delivered_food",
+			"ants_to_food",
+			"ants_to_home",
+			"ants_to_hell",
+			"mean_trip_length",
+			"pheromone_mass_to_home",
+			"pheromone_mass_to_food",
+			"pheromone_mass_to_hell",
+			"pheromone_mass_counter",
+			"malicious_trail_coverage"
+		};
+		return names[to<uint32_t>(metric)];
+	}
+
+	// Throws if the name isn't the one of a metric
+	static Metric fromName(const std::string& name)
+	{
+		for (uint32_t i(0); i < to<uint32_t>(Metric::Count); ++i) {
+			if (name == getName(static_cast<Metric>(i))) {
+				return static_cast<Metric>(i);
+			}
+		}
+		throw std::invalid_argument("Invalid metric " + name);
+	}
+
+	static bool isFieldMetric(Metric metric)
+	{
+		return metric >= Metric::MassToHome;
+	}
+
+	// The 4 historical columns of the CSV files
+	void addDefaultMetrics()
+	{
+		metrics.push_back(Metric::FoodFoundPerAnt);
+		metrics.push_back(Metric::FoodDeliveredPerAnt);
+		metrics.push_back(Metric::FractionFoundFood);
+		metrics.push_back(Metric::FractionDeliveredFood);
+	}
+
+	bool isSampleStep(uint32_t step) const
+	{
+		return step % interval == 0;
+	}
+
+	// Does a sample need the FieldStats of the grid ?
+	bool needsFieldStats() const
+	{
+		for (Metric metric : metrics) {
+			if (isFieldMetric(metric)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void addColumns(RunSeries& run) const
+	{
+		for (Metric metric : metrics) {
+			run.addColumn(getName(metric));
+		}
+	}
+
+	/**
+	 * @brief Append the current values of the metrics to a run
+	 *
+	 * @param ants_count Number of ants the per ant metrics are normalized with
+	 * @param field Statistics of the grid, only read if needsFieldStats()
+	 */
+	void sample(const SimulationContext& context, const FieldStats& field, uint32_t ants_count, RunSeries& run) const
+	{
+		const float ants = to<float>(ants_count);
+		for (uint64_t i(0); i < metrics.size(); ++i) {
+			run.columns[i].push_back(getValue(metrics[i], context, field, ants));
+		}
+	}
+
+private:
+	static float getValue(Metric metric, const SimulationContext& context, const FieldStats& field, float ants)
+	{
+		switch (metric) {
+		case Metric::FoodFoundPerAnt:
+			return float(context.food_bits_taken) / ants;
+		case Metric::FoodDeliveredPerAnt:
+			return float(context.food_bits_delivered) / ants;
+		case Metric::FractionFoundFood:
+			return float(context.ants_that_found_food) / ants;
+		case Metric::FractionDeliveredFood:
+			return float(context.ants_that_delivered_food) / ants;
+		case Metric::AntsToFood:
+			return float(context.ants_per_phase[to<uint32_t>(Mode::ToFood)]);
+		case Metric::AntsToHome:
+			return float(context.ants_per_phase[to<uint32_t>(Mode::ToHome)]);
+		case Metric::AntsToHell:
+			return float(context.ants_per_phase[to<uint32_t>(Mode::ToHell)]);
+		case Metric::MeanTripLength:
+			return context.trips_completed ? float(context.trip_steps) / float(context.trips_completed) : 0.0f;
+		case Metric::MassToHome:
+			return float(field.mass[to<uint32_t>(Mode::ToHome)]);
+		case Metric::MassToFood:
+			return float(field.mass[to<uint32_t>(Mode::ToFood)]);
+		case Metric::MassToHell:
+			return float(field.mass[to<uint32_t>(Mode::ToHell)]);
+		case Metric::MassCounter:
+			return float(field.mass[to<uint32_t>(Mode::CounterPhr)]);
+		case Metric::MaliciousTrailCoverage:
+			return float(field.covered_cells[to<uint32_t>(Mode::ToHell)]) / float(field.cell_count);
+		default:
+			return 0.0f;
+		}
+	}
+};
@@ -1,156 +1,180 @@
 #pragma once
-#include <random>
+#include <cstdint>
 
 
-class NumberGenerator
+// Per thread stream position, a template so it can be defined in this header
+template<typename T = void>
+struct CounterRNGState
 {
-protected:
-	std::random_device rd;
-	std::mt19937 gen;
-
-	NumberGenerator()
-		: gen(rd())
-	{}
+	static thread_local uint64_t key;
+	static thread_local uint64_t counter;
 };
 
+template<typename T>
+thread_local uint64_t CounterRNGState<T>::key = 0;
 
 template<typename T>
-class RealNumberGenerator : public NumberGenerator
-{
-private:
-	std::uniform_real_distribution<T> dis;
+thread_local uint64_t CounterRNGState<T>::counter = 0;
+
 
+/**
+ * @brief Counter based random number generator
+ *
+ * The n-th number of a stream is a hash of (key, n) so there is no generator state to share, any thread can
+ * reproduce any stream. A stream is keyed by (seed, stream id, step), the ants use their id as stream id
+ * which makes a run only depend on its seed, whatever the thread that updates each ant.
+ */
+class CounterRNG : private CounterRNGState<>
+{
 public:
-	RealNumberGenerator()
-		: NumberGenerator()
-		, dis(0.0f, 1.0f)		
-	{}
-	
-	// random_device is not copyable
-	RealNumberGenerator(const RealNumberGenerator<T>& right)
-		: NumberGenerator()
-		, dis(right.dis)
-	{}
+	// SplitMix64 finalizer, bijective 64 bits mixing
+	static uint64_t mix(uint64_t z)
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
 
-	float get()
+	static uint64_t getKey(uint64_t seed, uint64_t stream_id, uint64_t step)
 	{
-		return dis(gen);
+		uint64_t key = mix(seed + GOLDEN_GAMMA);
+		key = mix(key ^ (stream_id + GOLDEN_GAMMA));
+		return mix(key ^ (step + GOLDEN_GAMMA));
 	}
 
-	float getUnder(T max)
+	// Select the stream the following numbers are drawn from on this thread
+	static void setStream(uint64_t seed, uint64_t stream_id, uint64_t step)
 	{
-		return get() * max;
+		key = getKey(seed, stream_id, step);
+		counter = 0;
 	}
 
-	float getRange(T min, T max)
+	static uint64_t next()
 	{
-		return min + get() * (max - min);
+		return mix(key + (++counter) * GOLDEN_GAMMA);
 	}
 
-	float getRange(T width)
+	// Uniform float in [0, 1), the 24 high bits fill the whole mantissa
+	static float nextFloat()
 	{
-		return getRange(-width * 0.5f, width * 0.5f);
+		return static_cast<float>(next() >> 40) * TO_UNIT;
 	}
+
+	// count uniform floats in [min, max), independent iterations so the loop can be vectorized
+	static void fill(float* out, uint32_t count, float min, float max)
+	{
+		peek(out, count, min, max);
+		skip(count);
+	}
+
+	// Same as fill without consuming the numbers, skip() consumes the ones that were actually used
+	static void peek(float* out, uint32_t count, float min, float max)
+	{
+		const uint64_t base = key + counter * GOLDEN_GAMMA;
+		const float width = max - min;
+		for (uint32_t i(0); i < count; ++i) {
+			const uint64_t x = mix(base + (i + 1ull) * GOLDEN_GAMMA);
+			out[i] = min + static_cast<float>(x >> 40) * TO_UNIT * width;
+		}
+	}
+
+	static void skip(uint64_t count)
+	{
+		counter += count;
+	}
+
+private:
+	static constexpr uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+	static constexpr float TO_UNIT = 1.0f / 16777216.0f;
 };
 
 
 template<typename T>
 class RNG
 {
-private:
-	static RealNumberGenerator<T> gen;
-
 public:
 	static T get()
 	{
-		return gen.get();
+		return static_cast<T>(CounterRNG::nextFloat());
 	}
 
 	static float getUnder(T max)
 	{
-		return gen.getUnder(max);
+		return get() * max;
 	}
 
 	static uint64_t getUintUnder(uint64_t max)
 	{
-		return static_cast<uint64_t>(gen.getUnder(static_cast<float>(max) + 1.0f));
+		return static_cast<uint64_t>(getUnder(static_cast<float>(max) + 1.0f));
 	}
 
 	static float getRange(T min, T max)
 	{
-		return gen.getRange(min, max);
+		return min + get() * (max - min);
 	}
 
 	static float getRange(T width)
 	{
-		return gen.getRange(width);
+		return getRange(-width * 0.5f, width * 0.5f);
 	}
 
 	static float getFullRange(T width)
 	{
-		return gen.getRange(static_cast<T>(2.0f) * width);
+		return getRange(static_cast<T>(2.0f) * width);
 	}
 
 	static bool proba(float threshold)
 	{
 		return get() < threshold;
 	}
-};
-
-using RNGf = RNG<float>;
-
-template<typename T>
-RealNumberGenerator<T> RNG<T>::gen = RealNumberGenerator<T>();
 
+	// Batch version of getRange(min, max)
+	static void fillRange(T* out, uint32_t count, T min, T max)
+	{
+		CounterRNG::fill(out, count, min, max);
+	}
 
-template<typename T>
-class IntegerNumberGenerator : public NumberGenerator
-{
-public:
-	IntegerNumberGenerator()
-		: NumberGenerator()
-	{}
-
-	// random_device is not copyable
-	IntegerNumberGenerator(const IntegerNumberGenerator<T>& right)
-		: NumberGenerator()
-	{}
+	// Batch version of getRange(width)
+	static void fillRange(T* out, uint32_t count, T width)
+	{
+		fillRange(out, count, -width * 0.5f, width * 0.5f);
+	}
 
-	T getUnder(T max)
+	// The values the next count calls to get() would return, without consuming them
+	static void peek(T* out, uint32_t count)
 	{
-		std::uniform_int_distribution<std::mt19937::result_type> dist(0, max);
-		return dist(gen);
+		CounterRNG::peek(out, count, 0.0f, 1.0f);
 	}
 
-	T getRange(T min, T max)
+	static void skip(uint32_t count)
 	{
-		std::uniform_int_distribution<std::mt19937::result_type> dist(min, max);
-		return dist(gen);
+		CounterRNG::skip(count);
 	}
 };
 
+using RNGf = RNG<float>;
+
 
 template<typename T>
 class RNGi
 {
-private:
-	static IntegerNumberGenerator<T> gen;
-
 public:
+	// Uniform integer in [0, max]
 	static T getUnder(T max)
 	{
-		return gen.getUnder(max);
+		return getRange(0, max);
 	}
 
+	// Uniform integer in [min, max]
 	static T getRange(T min, T max)
 	{
-		return gen.getRange(min, max);
+		const uint64_t span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+		// A span of 0 means the whole 64 bits range
+		const uint64_t value = span ? CounterRNG::next() % span : CounterRNG::next();
+		return static_cast<T>(static_cast<uint64_t>(min) + value);
 	}
 };
 
-template<typename T>
-IntegerNumberGenerator<T> RNGi<T>::gen;
-
 using RNGi32 = RNGi<int32_t>;
 using RNGi64 = RNGi<int64_t>;
 using RNGu32 = RNGi<uint32_t>;
@@ -0,0 +1,148 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Cartesian product of the values of swept parameters
+ *
+ * Points are numbered with the last axis varying the fastest and are only built on request, so sweeps of
+ * any size cost the memory of their axes.
+ *
+ * A branch axis is a parameter that doesn't act before a step common to all its values, the points that only
+ * differ by branch axes share their first steps. They are grouped by their trunk, the point with the first
+ * value of every branch axis.
+ *
+ * @tparam TConfig Configuration the values of a point are applied to
+ */
+template<typename TConfig>
+struct ParameterSweep
+{
+	struct Axis
+	{
+		std::string name;
+		std::vector<double> values;
+		std::function<void(TConfig&, double)> apply;
+		bool branch;
+	};
+
+	std::vector<Axis> axes;
+
+	void addAxis(const std::string& name, const std::vector<double>& values, std::function<void(TConfig&, double)> apply, bool branch = false)
+	{
+		axes.push_back({name, values, apply, branch});
+	}
+
+	const Axis* getAxis(const std::string& name) const
+	{
+		for (const Axis& axis : axes) {
+			if (axis.name == name) {
+				return &axis;
+			}
+		}
+		return nullptr;
+	}
+
+	bool hasAxis(const std::string& name) const
+	{
+		return getAxis(name) != nullptr;
+	}
+
+	uint64_t getPointCount() const
+	{
+		uint64_t count = 1;
+		for (const Axis& axis : axes) {
+			count *= axis.values.size();
+		}
+		return count;
+	}
+
+	// Number of points sharing a trunk
+	uint64_t getBranchCount() const
+	{
+		uint64_t count = 1;
+		for (const Axis& axis : axes) {
+			count *= axis.branch ? axis.values.size() : 1;
+		}
+		return count;
+	}
+
+	// The point with the same values as this one except the first value of every branch axis
+	uint64_t getTrunk(uint64_t point) const
+	{
+		uint64_t trunk = 0;
+		uint64_t stride = 1;
+		for (uint64_t i(axes.size()); i--;) {
+			const uint64_t size = axes[i].values.size();
+			trunk += axes[i].branch ? 0 : (point % size) * stride;
+			point /= size;
+			stride *= size;
+		}
+		return trunk;
+	}
+
+	// Point of the given branch of a trunk, trunks and branches numbered like the points over their own axes
+	uint64_t getBranchPoint(uint64_t trunk_number, uint64_t branch) const
+	{
+		uint64_t point = 0;
+		uint64_t stride = 1;
+		for (uint64_t i(axes.size()); i--;) {
+			const uint64_t size = axes[i].values.size();
+			uint64_t& digits = axes[i].branch ? branch : trunk_number;
+			point += (digits % size) * stride;
+			digits /= size;
+			stride *= size;
+		}
+		return point;
+	}
+
+	// Set the values of a point in a configuration
+	void applyPoint(TConfig& config, uint64_t point) const
+	{
+		for (uint64_t i(axes.size()); i--;) {
+			const Axis& axis = axes[i];
+			const uint64_t size = axis.values.size();
+			axis.apply(config, axis.values[point % size]);
+			point /= size;
+		}
+	}
+
+	/**
+	 * @brief Parse the values of a parameter
+	 *
+	 * Accepts a single value, a space separated list ("1 5 10") or an inclusive range "start:stop:step".
+	 * Throws if the text isn't one of these.
+	 */
+	static std::vector<double> parseValues(const std::string& text)
+	{
+		std::vector<double> values;
+		if (text.find(':') != std::string::npos) {
+			std::istringstream ss(text);
+			double start, stop, step;
+			char sep1, sep2;
+			if (!(ss >> start >> sep1 >> stop >> sep2 >> step) || sep1 != ':' || sep2 != ':' || !(ss >> std::ws).eof() || step <= 0.0 || stop < start) {
+				throw std::invalid_argument("Invalid range \"" + text + "\", expected start:stop:step");
+			}
+			// Computed from the start to avoid accumulating rounding errors, the tolerance keeps the stop value
+			const uint64_t count = static_cast<uint64_t>(std::floor((stop - start) / step + 1e-9)) + 1;
+			for (uint64_t i(0); i < count; ++i) {
+				values.push_back(start + double(i) * step);
+			}
+			return values;
+		}
+		std::istringstream ss(text);
+		double value;
+		while (ss >> value) {
+			values.push_back(value);
+		}
+		if (values.empty() || !ss.eof()) {
+			throw std::invalid_argument("Invalid parameter values \"" + text + "\"");
+		}
+		return values;
+	}
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+
+/**
+ * @brief Evaporation kernels working on the WorldGrid planes
+ *
+ * The implementation (AVX2, SSE2 or scalar) is picked once at runtime from the CPU features unless one is forced
+ * with setImplementation, all of them produce bit-identical results.
+ */
+namespace PheromoneDecay
+{
+	/**
+	 * @brief Linear evaporation of one intensity plane, clamped at 0
+	 *
+	 * @param intensity Intensity plane of the channel
+	 * @param permanent Permanence bitmask plane, cells with mode_bit set don't evaporate
+	 * @param mode_bit Bit of the channel in the permanence bitmask
+	 * @param rate Intensity removed from each non permanent cell
+	 * @param count Number of cells
+	 */
+	void decayChannel(float* intensity, const uint8_t* permanent, uint8_t mode_bit, float rate, uint64_t count);
+
+	/**
+	 * @brief Evaporation of the food channel, removing the permanent food markers of cells without food
+	 *
+	 * @param food Food quantity plane
+	 */
+	void decayFoodChannel(float* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, float rate, uint64_t count);
+
+	/**
+	 * @brief Evaporation of a 16 bits fixed point plane, saturating at 0
+	 *
+	 * @param units Units removed from each non permanent cell
+	 */
+	void decayChannel(uint16_t* intensity, const uint8_t* permanent, uint8_t mode_bit, uint16_t units, uint64_t count);
+
+	void decayFoodChannel(uint16_t* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, uint16_t units, uint64_t count);
+
+	// Name of the implementation in use
+	const char* getImplementationName();
+
+	/**
+	 * @brief Force an implementation instead of the one selected for this CPU
+	 *
+	 * Not thread safe, call it while no decay runs.
+	 *
+	 * @param name "AVX2", "SSE2" or "scalar"
+	 * @return false if the name is unknown or the CPU doesn't support the implementation, which is then unchanged
+	 */
+	bool setImplementation(const std::string& name);
+}
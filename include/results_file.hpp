@@ -0,0 +1,214 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Parameters and time series of one run, stored by columns
+ */
+struct RunSeries
+{
+	struct Parameter
+	{
+		std::string name;
+		double value;
+	};
+
+	std::vector<Parameter> parameters;
+	std::vector<std::string> column_names;
+	std::vector<std::vector<float>> columns;
+
+	void addParameter(const std::string& name, double value)
+	{
+		parameters.push_back({name, value});
+	}
+
+	void addColumn(const std::string& name)
+	{
+		column_names.push_back(name);
+		columns.emplace_back();
+	}
+
+	// Values are given in column order
+	void addRow(std::initializer_list<float> values)
+	{
+		uint64_t i = 0;
+		for (float value : values) {
+			columns[i++].push_back(value);
+		}
+	}
+
+	uint64_t getRowCount() const
+	{
+		return columns.empty() ? 0 : columns.front().size();
+	}
+};
+
+
+/**
+ * @brief Single file holding the series of many runs
+ *
+ * Layout, little endian:
+ *   header   "ANTSIMR" '\0', u32 version
+ *   run      u32 size of the run record after this field
+ *            u32 parameter count, then per parameter: u16 name length, name, f64 value
+ *            u32 column count, u32 row count, then per column: u16 name length, name
+ *            float32 values, one column after the other
+ *
+ * Runs are appended as whole records so a file is readable up to its last complete run,
+ * even if the simulation was interrupted.
+ */
+namespace ResultsFile
+{
+	const char MAGIC[8] = {'A', 'N', 'T', 'S', 'I', 'M', 'R', '\0'};
+	const uint32_t VERSION = 1;
+
+	/**
+	 * @brief Appends runs to a results file, can be shared by concurrent trials
+	 */
+	class Writer
+	{
+	public:
+		// Create or truncate the file, throws if it can't be opened
+		explicit Writer(const std::string& path)
+			: file(std::fopen(path.c_str(), "wb"))
+		{
+			if (!file) {
+				throw std::runtime_error("Cannot create results file " + path);
+			}
+			std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+			std::fwrite(&VERSION, sizeof(VERSION), 1, file);
+			std::fflush(file);
+		}
+
+		~Writer()
+		{
+			std::fclose(file);
+		}
+
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		void write(const RunSeries& run)
+		{
+			// Serialize outside of the lock, the record is then written at once
+			std::vector<char> record;
+			append(record, static_cast<uint32_t>(0));
+			append(record, static_cast<uint32_t>(run.parameters.size()));
+			for (const RunSeries::Parameter& parameter : run.parameters) {
+				appendString(record, parameter.name);
+				append(record, parameter.value);
+			}
+			const uint32_t row_count = static_cast<uint32_t>(run.getRowCount());
+			append(record, static_cast<uint32_t>(run.columns.size()));
+			append(record, row_count);
+			for (const std::string& name : run.column_names) {
+				appendString(record, name);
+			}
+			for (const std::vector<float>& column : run.columns) {
+				appendBytes(record, column.data(), row_count * sizeof(float));
+			}
+			const uint32_t record_size = static_cast<uint32_t>(record.size() - sizeof(uint32_t));
+			std::memcpy(record.data(), &record_size, sizeof(record_size));
+
+			std::lock_guard<std::mutex> lock(mutex);
+			std::fwrite(record.data(), 1, record.size(), file);
+			std::fflush(file);
+		}
+
+	private:
+		std::FILE* file;
+		std::mutex mutex;
+
+		static void appendBytes(std::vector<char>& out, const void* data, uint64_t size)
+		{
+			const char* bytes = static_cast<const char*>(data);
+			out.insert(out.end(), bytes, bytes + size);
+		}
+
+		template<typename T>
+		static void append(std::vector<char>& out, T value)
+		{
+			appendBytes(out, &value, sizeof(T));
+		}
+
+		static void appendString(std::vector<char>& out, const std::string& str)
+		{
+			append(out, static_cast<uint16_t>(str.size()));
+			appendBytes(out, str.data(), str.size());
+		}
+	};
+
+	/**
+	 * @brief Read all the complete runs of a results file, throws if the file isn't a results file
+	 */
+	inline std::vector<RunSeries> read(const std::string& path)
+	{
+		std::FILE* file = std::fopen(path.c_str(), "rb");
+		if (!file) {
+			throw std::runtime_error("Cannot open results file " + path);
+		}
+		char magic[sizeof(MAGIC)];
+		uint32_t version = 0;
+		const bool valid_header = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+			&& std::fread(&version, sizeof(version), 1, file) == 1
+			&& !std::memcmp(magic, MAGIC, sizeof(MAGIC))
+			&& version == VERSION;
+		if (!valid_header) {
+			std::fclose(file);
+			throw std::runtime_error(path + " is not a results file");
+		}
+
+		std::vector<RunSeries> runs;
+		uint32_t record_size;
+		std::vector<char> record;
+		while (std::fread(&record_size, sizeof(record_size), 1, file) == 1) {
+			record.resize(record_size);
+			if (std::fread(record.data(), 1, record_size, file) != record_size) {
+				// Truncated last run
+				break;
+			}
+			const char* cursor = record.data();
+			auto get = [&cursor](void* out, uint64_t size) {
+				std::memcpy(out, cursor, size);
+				cursor += size;
+			};
+			auto getString = [&get, &cursor]() {
+				uint16_t length;
+				get(&length, sizeof(length));
+				const std::string str(cursor, length);
+				cursor += length;
+				return str;
+			};
+
+			RunSeries run;
+			uint32_t parameter_count;
+			get(&parameter_count, sizeof(parameter_count));
+			for (uint32_t i(0); i < parameter_count; ++i) {
+				const std::string name = getString();
+				double value;
+				get(&value, sizeof(value));
+				run.addParameter(name, value);
+			}
+			uint32_t column_count, row_count;
+			get(&column_count, sizeof(column_count));
+			get(&row_count, sizeof(row_count));
+			for (uint32_t i(0); i < column_count; ++i) {
+				run.addColumn(getString());
+			}
+			for (std::vector<float>& column : run.columns) {
+				column.resize(row_count);
+				get(column.data(), row_count * sizeof(float));
+			}
+			runs.push_back(std::move(run));
+		}
+		std::fclose(file);
+		return runs;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "results_file.hpp"
+
+
+/**
+ * @brief Statistics of repeated runs, datapoint by datapoint
+ *
+ * Runs are folded one at a time with Welford's algorithm so the runs themselves don't have to be kept.
+ * All the runs must have the same columns and row count.
+ */
+struct RunSummary
+{
+	struct Accumulator
+	{
+		double mean = 0.0;
+		// Sum of the squared differences to the mean
+		double m2 = 0.0;
+		float min = 0.0f;
+		float max = 0.0f;
+
+		void add(float value, uint64_t count)
+		{
+			const double delta = value - mean;
+			mean += delta / double(count);
+			m2 += delta * (value - mean);
+			min = count > 1 ? std::min(min, value) : value;
+			max = count > 1 ? std::max(max, value) : value;
+		}
+	};
+
+	// Parameters and column names of the first run
+	RunSeries layout;
+	// Accumulators of each column, one per row
+	std::vector<std::vector<Accumulator>> columns;
+	uint64_t run_count = 0;
+
+	void add(const RunSeries& run)
+	{
+		const uint64_t row_count = run.getRowCount();
+		if (!run_count) {
+			layout.parameters = run.parameters;
+			layout.column_names = run.column_names;
+			columns.assign(run.columns.size(), std::vector<Accumulator>(row_count));
+		}
+		else if (run.column_names != layout.column_names || row_count != columns.front().size()) {
+			throw std::invalid_argument("Runs of a summary must have the same columns and rows");
+		}
+		++run_count;
+		for (uint64_t c(0); c < columns.size(); ++c) {
+			for (uint64_t r(0); r < row_count; ++r) {
+				columns[c][r].add(run.columns[c][r], run_count);
+			}
+		}
+	}
+
+	/**
+	 * @brief Summary as a run, each column gives a _mean, _var, _min and _max column
+	 *
+	 * The variance is the unbiased one, 0 for a single run.
+	 *
+	 * @param excluded_parameter Parameter that differs between the runs (the iteration), left out of the summary
+	 */
+	RunSeries getSeries(const std::string& excluded_parameter) const
+	{
+		RunSeries series;
+		for (const RunSeries::Parameter& parameter : layout.parameters) {
+			if (parameter.name != excluded_parameter) {
+				series.addParameter(parameter.name, parameter.value);
+			}
+		}
+		series.addParameter("runs", double(run_count));
+		for (uint64_t c(0); c < columns.size(); ++c) {
+			const std::string& name = layout.column_names[c];
+			series.addColumn(name + "_mean");
+			series.addColumn(name + "_var");
+			series.addColumn(name + "_min");
+			series.addColumn(name + "_max");
+			for (const Accumulator& acc : columns[c]) {
+				series.columns[4 * c + 0].push_back(float(acc.mean));
+				series.columns[4 * c + 1].push_back(run_count > 1 ? float(acc.m2 / double(run_count - 1)) : 0.0f);
+				series.columns[4 * c + 2].push_back(acc.min);
+				series.columns[4 * c + 3].push_back(acc.max);
+			}
+		}
+		return series;
+	}
+};
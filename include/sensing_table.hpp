@@ -0,0 +1,35 @@
+#pragma once
+#include <cmath>
+#include "utils.hpp"
+
+
+/**
+ * @brief Unit vectors of the angle offsets an ant samples the world at
+ *
+ * The sampling arc is split in SIZE bins, an offset is the center of a bin. With 1024 bins the angle error
+ * is at most 0.0013 rad, around 0.05 pixel at the maximum detection distance, far below the size of a cell.
+ */
+struct SensingTable
+{
+	static constexpr uint32_t SIZE = 1024;
+
+	float cos_offset[SIZE];
+	float sin_offset[SIZE];
+
+	explicit SensingTable(float angle_range)
+	{
+		const float bin_width = angle_range / to<float>(SIZE);
+		for (uint32_t i(0); i < SIZE; ++i) {
+			const float offset = -0.5f * angle_range + (to<float>(i) + 0.5f) * bin_width;
+			cos_offset[i] = std::cos(offset);
+			sin_offset[i] = std::sin(offset);
+		}
+	}
+
+	// Table of the sampling arc of the ants, PI * 0.8 wide and centered on their direction
+	static const SensingTable& get()
+	{
+		static const SensingTable table(PI * 0.8f);
+		return table;
+	}
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+
+
+/**
+ * @brief Parameters and counters of a single simulation run
+ *
+ * Every World/Colony pair is updated with its own context, which allows several simulations to run in the same process.
+ */
+struct SimulationContext
+{
+	// Maximum value of the counter pheromone dilusion counter
+	float dilusion_max = 0.0f;
+	// Amount the dilusion counter recovers per direction update without marker
+	float dilusion_increment = 0.0f;
+	// Evaporation rate multiplier of the ToHell pheromone
+	float hell_phermn_evpr_multi = 1.0f;
+	// Evaporation rate multiplier of the counter pheromone
+	float cntr_phermn_evpr_multi = 0.0f;
+	// Seed of the random streams of the ants
+	uint64_t seed = 0;
+
+	// Food bits picked up by all ants
+	int food_bits_taken = 0;
+	// Food bits brought back to the colony by all ants
+	int food_bits_delivered = 0;
+	// Ants that found food at least once, refreshed every colony update
+	int ants_that_found_food = 0;
+	// Ants that delivered food at least once, refreshed every colony update
+	int ants_that_delivered_food = 0;
+	// Ants in each phase, indexed by Mode, refreshed every colony update
+	int ants_per_phase[4] = { 0, 0, 0, 0 };
+	// Round trips ended by a delivery and their total length in steps
+	int trips_completed = 0;
+	uint64_t trip_steps = 0;
+
+	void resetCounters()
+	{
+		food_bits_taken = 0;
+		food_bits_delivered = 0;
+		ants_that_found_food = 0;
+		ants_that_delivered_food = 0;
+		resetPhaseCounters();
+		trips_completed = 0;
+		trip_steps = 0;
+	}
+
+	void resetPhaseCounters()
+	{
+		for (int& count : ants_per_phase) {
+			count = 0;
+		}
+	}
+
+	// Add the counters of a context that tracked a subset of the ants
+	void addCounters(const SimulationContext& other)
+	{
+		food_bits_taken += other.food_bits_taken;
+		food_bits_delivered += other.food_bits_delivered;
+		ants_that_found_food += other.ants_that_found_food;
+		ants_that_delivered_food += other.ants_that_delivered_food;
+		for (uint32_t i(0); i < 4; ++i) {
+			ants_per_phase[i] += other.ants_per_phase[i];
+		}
+		trips_completed += other.trips_completed;
+		trip_steps += other.trip_steps;
+	}
+};
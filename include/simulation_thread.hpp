@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Runs the steps of the displayed simulation on its own thread
+ *
+ * The display allows steps_per_frame steps for each frame it shows, or as many as the thread can simulate in fast
+ * forward, so the frame rate doesn't limit the simulation. Commands (the edits of the world) are queued by the
+ * display and run between two steps.
+ *
+ * The steps and the commands run with the state locked, the display locks it with lockState to read a consistent
+ * state. The next step waits for a display that asked for the lock, a fast forward can't starve the display.
+ * Background readers such as the field renderers lock it part by part with lockStateBetweenSteps, which gives
+ * them no priority over the steps.
+ */
+class SimulationThread
+{
+public:
+	/**
+	 * @brief Start the thread, paused until the first frame is requested
+	 *
+	 * @param step_ Simulates one step
+	 * @param steps_per_frame_ Steps simulated for each frame outside of fast forward
+	 */
+	SimulationThread(std::function<void()> step_, uint32_t steps_per_frame_)
+		: step(step_)
+		, steps_per_frame(steps_per_frame_)
+		, allowed_steps(0)
+		, paused(false)
+		, fast_forward(false)
+		, run(true)
+		, step_count(0)
+		, display_waiting(false)
+		, state_version(0)
+	{
+		thread = std::thread([this]() { simulate(); });
+	}
+
+	~SimulationThread()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			run = false;
+		}
+		wake_up.notify_one();
+		thread.join();
+	}
+
+	// Run a command before the next step, even when paused
+	void addCommand(std::function<void()> command)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			commands.push_back(std::move(command));
+		}
+		wake_up.notify_one();
+	}
+
+	// A frame is shown, the steps it allowed and didn't simulate yet are dropped
+	void requestFrame(bool paused_, bool fast_forward_)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			allowed_steps = steps_per_frame;
+			paused = paused_;
+			fast_forward = fast_forward_;
+		}
+		wake_up.notify_one();
+	}
+
+	uint64_t getStepCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return step_count;
+	}
+
+	// Lock the world and the colony, no step nor command runs until the lock is released
+	std::unique_lock<std::mutex> lockState()
+	{
+		display_waiting = true;
+		std::unique_lock<std::mutex> lock(state_mutex);
+		display_waiting = false;
+		return lock;
+	}
+
+	// Changes whenever a step or a command modifies the world or the colony
+	uint64_t getStateVersion() const
+	{
+		return state_version;
+	}
+
+	// Lock the world and the colony without delaying the next step, for readers that lock them often
+	std::unique_lock<std::mutex> lockStateBetweenSteps()
+	{
+		return std::unique_lock<std::mutex>(state_mutex);
+	}
+
+private:
+	std::function<void()> step;
+	const uint32_t steps_per_frame;
+
+	// Protects the requests of the display
+	mutable std::mutex mutex;
+	std::condition_variable wake_up;
+	std::vector<std::function<void()>> commands;
+	uint32_t allowed_steps;
+	bool paused;
+	bool fast_forward;
+	bool run;
+	uint64_t step_count;
+
+	// Held during the steps and the commands
+	std::mutex state_mutex;
+	std::atomic<bool> display_waiting;
+	// Steps and batches of commands run so far
+	std::atomic<uint64_t> state_version;
+
+	std::thread thread;
+
+	void simulate()
+	{
+		std::vector<std::function<void()>> pending_commands;
+		while (true) {
+			bool do_step;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake_up.wait(lock, [this]() { return !run || !commands.empty() || canStep(); });
+				if (!run) {
+					return;
+				}
+				pending_commands.swap(commands);
+				do_step = canStep();
+				allowed_steps -= do_step && !fast_forward ? 1 : 0;
+			}
+			while (display_waiting) {
+				std::this_thread::yield();
+			}
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				for (const std::function<void()>& command : pending_commands) {
+					command();
+				}
+				if (do_step) {
+					step();
+				}
+				if (do_step || !pending_commands.empty()) {
+					++state_version;
+				}
+			}
+			pending_commands.clear();
+			if (do_step) {
+				std::lock_guard<std::mutex> lock(mutex);
+				++step_count;
+			}
+		}
+	}
+
+	bool canStep() const
+	{
+		return !paused && (fast_forward || allowed_steps);
+	}
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <vector>
+
+
+/**
+ * @brief Fixed size pool of worker threads consuming a FIFO job queue
+ *
+ * Jobs must not share mutable state with each other, the pool only provides scheduling.
+ */
+struct WorkerPool
+{
+	/**
+	 * @brief Construct a new WorkerPool object
+	 *
+	 * @param thread_count Number of worker threads; 0 uses the number of hardware threads
+	 */
+	explicit WorkerPool(uint32_t thread_count = 0)
+		: pending_jobs(0)
+		, run(true)
+	{
+		if (!thread_count) {
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+		for (uint32_t i(0); i < thread_count; ++i) {
+			workers.emplace_back([this]() { work(); });
+		}
+	}
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			run = false;
+		}
+		job_available.notify_all();
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void addJob(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push(std::move(job));
+			++pending_jobs;
+		}
+		job_available.notify_one();
+	}
+
+	// Block until every job added so far has completed
+	void waitForCompletion()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		jobs_done.wait(lock, [this]() { return pending_jobs == 0; });
+	}
+
+	uint32_t getThreadCount() const
+	{
+		return static_cast<uint32_t>(workers.size());
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable job_available;
+	std::condition_variable jobs_done;
+	uint64_t pending_jobs;
+	bool run;
+
+	void work()
+	{
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				job_available.wait(lock, [this]() { return !run || !jobs.empty(); });
+				if (jobs.empty()) {
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop();
+			}
+			job();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--pending_jobs;
+			}
+			jobs_done.notify_all();
+		}
+	}
+};
@@ -8,34 +8,30 @@
 #include "wall.hpp"
 #include "grid.hpp"
 #include "ant_mode.hpp"
-#include "world_renderer.hpp"
+#include "simulation_context.hpp"
 
 
 struct World
 {
 	sf::Vector2f size;
 	WorldGrid markers;
-	DoubleObject<sf::VertexArray> va_markers;
-	DoubleObject<sf::VertexArray> va_walls;
-	WorldRenderer renderer;
 
-	World(uint32_t width, uint32_t height)
-		: markers(width, height, 4)
+	World(uint32_t width, uint32_t height, bool lazy_decay = false, GridLayout layout = GridLayout::RowMajor)
+		: markers(width, height, 4, lazy_decay, layout)
 		, size(to<float>(width), to<float>(height))
-		, renderer(markers, va_markers)
 	{
 		for (int32_t x(0); x < markers.width; x++) {
 			for (int32_t y(0); y < markers.height; y++) {
 				if (x == 0 || x == markers.width - 1 || y == 0 || y == markers.height - 1) {
-					markers.get(sf::Vector2i(x, y)).wall = 1;
+					markers.setWall(sf::Vector2i(x, y), true);
 				}
 			}
 		}
 	}
 
-	void update(float dt)
+	void update(float dt, const SimulationContext& context, FieldStats* stats = nullptr)
 	{
-		markers.update(dt);
+		markers.update(dt, context, stats);
 	}
 
 	void addMarker(sf::Vector2f pos, Mode type, float intensity, bool permanent = false)
@@ -43,28 +39,30 @@ struct World
 		markers.addMarker(pos, type, intensity, permanent);
 	}
 
+	void scaleMarker(const WorldCell& cell, Mode type, float factor)
+	{
+		markers.scaleMarker(cell, type, factor);
+	}
+
+	void pickFood(sf::Vector2f pos)
+	{
+		markers.pickFood(pos);
+	}
+
 	void addWall(const sf::Vector2f& position)
 	{
 		if (markers.checkCoords(position)) {
-			markers.get(position).wall = 1;
+			markers.setWall(markers.getCellCoords(position), true);
 		}
 	}
 
 	void removeWall(const sf::Vector2f& position)
 	{
 		if (markers.checkCoords(position)) {
-			markers.get(position).wall = 0;
+			markers.setWall(markers.getCellCoords(position), false);
 		}
 	}
 
-	void renderMarkers(sf::RenderTarget& target, sf::RenderStates states)
-	{
-		states.texture = &(*Conf::MARKER_TEXTURE);
-		renderer.mutex.lock();
-		target.draw(va_markers.getCurrent(), states);
-		renderer.mutex.unlock();
-	}
-
 	void addFoodAt(float x, float y, uint32_t quantity)
 	{
 		const sf::Vector2f pos(x, y);
@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <SFML/System.hpp>
+
+#include "world.hpp"
+#include "ant_mode.hpp"
+
+
+/**
+ * @brief Records the World writes of a group of ants so they can be applied later
+ *
+ * Exposes the same writing methods as World, ants updated with a buffer read a field that stays
+ * untouched during the step. Applying the buffers of consecutive ant ranges one after the other
+ * reproduces the writes in ant order whatever the way the ants were split, ranges of edits can also be
+ * applied on their own to replay the writes in another order.
+ */
+struct WorldEditBuffer
+{
+	enum class EditType : uint8_t
+	{
+		AddMarker,
+		ScaleMarker,
+		PickFood
+	};
+
+	struct Edit
+	{
+		EditType type;
+		Mode mode;
+		uint64_t index;
+		float value;
+	};
+
+	const WorldGrid& grid;
+	std::vector<Edit> edits;
+
+	explicit WorldEditBuffer(const World& world)
+		: grid(world.markers)
+	{}
+
+	void addMarker(sf::Vector2f pos, Mode type, float intensity)
+	{
+		edits.push_back({EditType::AddMarker, type, grid.getIndex(pos), intensity});
+	}
+
+	void scaleMarker(const WorldCell& cell, Mode type, float factor)
+	{
+		edits.push_back({EditType::ScaleMarker, type, cell.index, factor});
+	}
+
+	void pickFood(sf::Vector2f pos)
+	{
+		edits.push_back({EditType::PickFood, Mode::ToFood, grid.getIndex(pos), 0.0f});
+	}
+
+	void apply(World& world) const
+	{
+		apply(world, 0, edits.size());
+	}
+
+	// Apply the edits of indexes [begin, end)
+	void apply(World& world, uint64_t begin, uint64_t end) const
+	{
+		WorldGrid& markers = world.markers;
+		for (uint64_t i(begin); i < end; ++i) {
+			const Edit& edit = edits[i];
+			switch (edit.type) {
+			case EditType::AddMarker:
+				markers.addMarker(edit.index, edit.mode, edit.value);
+				break;
+			case EditType::ScaleMarker:
+				markers.scaleMarker(edit.index, edit.mode, edit.value);
+				break;
+			case EditType::PickFood:
+				markers.pickFood(edit.index);
+				break;
+			}
+		}
+	}
+
+	void clear()
+	{
+		edits.clear();
+	}
+};
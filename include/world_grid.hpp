@@ -1,134 +1,410 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 
 #include "ant_mode.hpp"
 #include "utils.hpp"
 #include "grid.hpp"
+#include "simulation_context.hpp"
+#include "pheromone_decay.hpp"
+#include "intensity_storage.hpp"
 
 
+struct WorldGrid;
+
+
+/**
+ * @brief Read only handle on a cell of the WorldGrid
+ *
+ * The cell data is spread over the planes of the grid, a default constructed handle refers to no cell.
+ */
 struct WorldCell
 {
-	// Stores the intensity of ToHome and ToFood markers
-	float intensity[4];
-	// Is the marker permanent ?
-	bool permanent[4];
-	// Food quantity in the cell
-	uint32_t food;
-	uint32_t wall;
+	const WorldGrid* grid;
+	uint64_t index;
 
-	inline static float hell_phermn_evpr_multi;
-	inline static float cntr_phermn_evpr_multi;
-	
 	WorldCell()
-		: intensity{ 0.0f, 0.0f , 0.0f, 0.0f }
-		, permanent{ false, false, false, false }
-		, food(0)
-		, wall(0)
+		: grid(nullptr)
+		, index(0)
 	{}
 
-	void update(float dt)
-	{
-		// Update intensities
-		intensity[0] -= (!permanent[0]) * dt;
-		intensity[1] -= (!permanent[1]) * dt;
-		intensity[2] -= (!permanent[2]) * dt * hell_phermn_evpr_multi;
-		intensity[3] -= (!permanent[3]) * dt * cntr_phermn_evpr_multi;;
-		// Avoid negative values
-		intensity[0] = std::max(0.0f, intensity[0]);
-		intensity[1] = std::max(0.0f, intensity[1]);
-		intensity[2] = std::max(0.0f, intensity[2]);
-		intensity[3] = std::max(0.0f, intensity[3]);
-		// Remove food marker if no food
-		intensity[1] = intensity[1] * to<float>(!bool(!food && permanent[1]));
-		permanent[1] &= to<bool>(food);
-	}
-
-	static void setHellPhermnEvprMulti(float multiplier)
-	{
-		WorldCell::hell_phermn_evpr_multi = multiplier;
-	}
+	WorldCell(const WorldGrid& grid_, uint64_t index_)
+		: grid(&grid_)
+		, index(index_)
+	{}
 
-	static void setCntrPhermnEvprMulti(float multiplier)
+	explicit operator bool() const
 	{
-		WorldCell::cntr_phermn_evpr_multi = multiplier;
+		return grid != nullptr;
 	}
 
-	void pick()
-	{
-		food -= bool(food);
-	}
+	float getIntensity(Mode mode) const;
+	bool isPermanent(Mode mode) const;
+	uint32_t getFood() const;
+	bool isWall() const;
 };
 
 
 struct HitPoint
 {
-	const WorldCell* cell;
+	WorldCell cell;
 	sf::Vector2f normal;
 
 	HitPoint()
-		: cell(nullptr)
 	{}
 
 	HitPoint(const WorldCell& c, sf::Vector2f n)
-		: cell(&c)
+		: cell(c)
 		, normal(n)
 	{}
 
 };
 
 
-struct WorldGrid : public Grid<WorldCell>
+/**
+ * @brief Totals of the pheromone planes, computed by WorldGrid::update on request
+ */
+struct FieldStats
+{
+	// Sum of the intensities of each Mode
+	double mass[4];
+	// Cells with a non zero intensity in each Mode
+	uint64_t covered_cells[4];
+	uint64_t cell_count;
+
+	FieldStats()
+		: mass{ 0.0, 0.0, 0.0, 0.0 }
+		, covered_cells{ 0, 0, 0, 0 }
+		, cell_count(0)
+	{}
+};
+
+
+/**
+ * @brief Pheromone field stored as a structure of arrays
+ *
+ * Each Mode has its own contiguous intensity plane so the decay streams one channel at a time,
+ * the permanence of the markers is a per cell bitmask (bit i for Mode i).
+ *
+ * In lazy decay mode update() doesn't sweep the grid. Since the evaporation is linear, the planes hold
+ * the intensities as of the step stored in last_update and the decayed values are computed on read.
+ * Cells are brought up to date before any write.
+ *
+ * With the tiled layout the planes are padded to whole tiles, the padding cells are never written and stay empty.
+ *
+ * The storage is split in active tiles of 256 cells, the 16x16 tiles of the tiled layout or runs of 256 cells of
+ * a row in the row major one. A bitmap tracks the tiles that hold markers: writes set their bit, the evaporation
+ * only visits those tiles and clears the bit of the tiles it empties. An empty cell stays empty when it
+ * evaporates, so skipping them doesn't change the field.
+ *
+ * wall_distance holds the Chebyshev distance in cells from each cell to the nearest wall, saturated at
+ * MAX_WALL_DISTANCE. setWall keeps it up to date around the modified cell, getFirstHit uses it to skip the walk
+ * of the rays that can't reach a wall.
+ */
+struct WorldGrid : public GridGeometry
 {
-	WorldGrid(uint32_t width_, uint32_t height_, uint32_t cell_size_)
-		: Grid(width_, height_, cell_size_)
+	static constexpr uint32_t MODE_COUNT = 4;
+	static constexpr uint32_t ACTIVE_TILE_SHIFT = 2 * TILE_SHIFT;
+	static constexpr uint64_t MAX_DECAY_RUN = 8;
+	static constexpr int32_t MAX_WALL_DISTANCE = 15;
+
+	// Intensity of the markers, one plane per Mode
+	std::vector<IntensityStorage::Value> intensity[MODE_COUNT];
+	// Is the marker permanent ? One bit per Mode
+	std::vector<uint8_t> permanent;
+	// Food quantity in the cell
+	std::vector<uint32_t> food;
+	std::vector<uint8_t> wall;
+	// Distance to the nearest wall in cells, derived from wall
+	std::vector<uint8_t> wall_distance;
+
+	const bool lazy_decay;
+	// Lazy decay: step at which each cell's intensities were last written
+	std::vector<uint32_t> last_update;
+	// Lazy decay: number of update() calls so far
+	uint32_t current_step;
+	// Lazy decay: intensity removed per step in each channel
+	float decay_rate[MODE_COUNT];
+	// Fraction of the evaporation of each channel that the planes don't hold yet, see IntensityStorage
+	double decay_carry[MODE_COUNT];
+	// One bit per active tile, set if a cell of the tile may hold a marker. Lazy decay never clears them.
+	std::vector<uint64_t> active_tiles;
+
+	WorldGrid(uint32_t width_, uint32_t height_, uint32_t cell_size_, bool lazy_decay_ = false, GridLayout layout_ = GridLayout::RowMajor)
+		: GridGeometry(width_, height_, cell_size_, layout_)
+		, lazy_decay(lazy_decay_)
+		, current_step(0)
+		, decay_rate{ 0.0f, 0.0f, 0.0f, 0.0f }
+		, decay_carry{ 0.0, 0.0, 0.0, 0.0 }
+	{
+		const uint64_t cell_count = getStorageSize();
+		for (std::vector<IntensityStorage::Value>& plane : intensity) {
+			plane.assign(cell_count, IntensityStorage::encode(0.0f));
+		}
+		permanent.assign(cell_count, 0);
+		food.assign(cell_count, 0);
+		wall.assign(cell_count, 0);
+		wall_distance.assign(cell_count, MAX_WALL_DISTANCE);
+		if (lazy_decay) {
+			last_update.assign(cell_count, 0);
+		}
+		active_tiles.assign((getActiveTileCount() + 63) / 64, 0);
+	}
+
+	static uint8_t getModeBit(Mode mode)
+	{
+		return static_cast<uint8_t>(1u << to<uint32_t>(mode));
+	}
+
+	uint64_t getActiveTileCount() const
+	{
+		return (getStorageSize() + (1u << ACTIVE_TILE_SHIFT) - 1) >> ACTIVE_TILE_SHIFT;
+	}
+
+	bool isTileActive(uint64_t tile) const
+	{
+		return (active_tiles[tile >> 6] >> (tile & 63)) & 1;
+	}
+
+	// Can the cell hold a marker ? All its intensities are 0 otherwise
+	bool isActive(uint64_t index) const
+	{
+		return isTileActive(index >> ACTIVE_TILE_SHIFT);
+	}
+
+	// Mark the tiles holding markers, after the planes were written directly
+	void updateActiveTiles()
+	{
+		const uint64_t tile_count = getActiveTileCount();
+		for (uint64_t tile(0); tile < tile_count; ++tile) {
+			setTileActive(tile, !isTileEmpty(tile));
+		}
+	}
+
+	uint64_t getIndex(sf::Vector2f pos) const
+	{
+		return getIndexFromCoords(getCellCoords(pos));
+	}
+
+	WorldCell getSafe(sf::Vector2f pos) const
+	{
+		const sf::Vector2i cell_coords = getCellCoords(pos);
+		if (checkCoords(cell_coords)) {
+			return getCst(cell_coords);
+		}
+		return WorldCell();
+	}
+
+	WorldCell getCst(sf::Vector2i cell_coord) const
+	{
+		return WorldCell(*this, getIndexFromCoords(cell_coord));
+	}
+
+	WorldCell getCst(sf::Vector2f position) const
+	{
+		return getCst(getCellCoords(position));
+	}
+
+	float getIntensity(uint64_t index, Mode mode) const
+	{
+		const uint32_t mode_index = to<uint32_t>(mode);
+		const float value = IntensityStorage::decode(intensity[mode_index][index]);
+		if (!lazy_decay || (permanent[index] & getModeBit(mode))) {
+			return value;
+		}
+		const float elapsed = to<float>(current_step - last_update[index]);
+		return std::max(0.0f, value - elapsed * decay_rate[mode_index]);
+	}
+
+	void addMarker(sf::Vector2f pos, Mode type, float intensity_, bool permanent_ = false)
 	{
+		addMarker(getIndex(pos), type, intensity_, permanent_);
 	}
 
-	void addMarker(sf::Vector2f pos, Mode type, float intensity, bool permanent = false)
+	void addMarker(uint64_t index, Mode type, float intensity_, bool permanent_ = false)
 	{
-		WorldCell& cell = get(pos);
+		refresh(index);
+		activate(index);
 		const uint32_t mode_index = to<uint32_t>(type);
-		cell.permanent[mode_index] |= permanent;
-		cell.intensity[mode_index] = std::max(cell.intensity[mode_index], intensity);
+		permanent[index] |= permanent_ ? getModeBit(type) : 0;
+		intensity[mode_index][index] = std::max(intensity[mode_index][index], IntensityStorage::encode(intensity_));
+	}
+
+	void scaleMarker(const WorldCell& cell, Mode type, float factor)
+	{
+		scaleMarker(cell.index, type, factor);
+	}
+
+	void scaleMarker(uint64_t index, Mode type, float factor)
+	{
+		refresh(index);
+		IntensityStorage::Value& value = intensity[to<uint32_t>(type)][index];
+		value = IntensityStorage::encode(IntensityStorage::decode(value) * factor);
 	}
 
 	void addFood(sf::Vector2f pos, uint32_t quantity)
 	{
-		WorldCell& cell = get(pos);
-		cell.food += quantity;
-		cell.intensity[1] = 1.0f;
-		cell.permanent[1] = true;
+		const uint64_t index = getIndex(pos);
+		refresh(index);
+		activate(index);
+		food[index] += quantity;
+		intensity[1][index] = IntensityStorage::encode(1.0f);
+		permanent[index] |= getModeBit(Mode::ToFood);
 	}
 
 	void remove(sf::Vector2f pos, Mode type)
 	{
-		WorldCell& cell = get(pos);
-		const uint32_t mode_index = to<uint32_t>(type);
-		cell.permanent[mode_index] = false;
-		cell.intensity[mode_index] = 0.0f;
+		const uint64_t index = getIndex(pos);
+		refresh(index);
+		permanent[index] &= ~getModeBit(type);
+		intensity[to<uint32_t>(type)][index] = IntensityStorage::encode(0.0f);
 	}
 
-	void update(float dt)
+	void setWall(sf::Vector2i cell_coord, bool is_wall)
 	{
-		for (WorldCell& c : cells) {
-			c.update(dt);
+		const uint64_t index = getIndexFromCoords(cell_coord);
+		if (wall[index] == is_wall) {
+			return;
+		}
+		wall[index] = is_wall;
+		const int32_t x0 = std::max(cell_coord.x - MAX_WALL_DISTANCE, 0);
+		const int32_t y0 = std::max(cell_coord.y - MAX_WALL_DISTANCE, 0);
+		const int32_t x1 = std::min(cell_coord.x + MAX_WALL_DISTANCE + 1, width);
+		const int32_t y1 = std::min(cell_coord.y + MAX_WALL_DISTANCE + 1, height);
+		if (is_wall) {
+			// Only brings cells closer to a wall
+			for (int32_t y(y0); y < y1; ++y) {
+				for (int32_t x(x0); x < x1; ++x) {
+					const int32_t distance = std::max(std::abs(x - cell_coord.x), std::abs(y - cell_coord.y));
+					uint8_t& cell_distance = wall_distance[getIndexFromCoords(sf::Vector2i(x, y))];
+					cell_distance = static_cast<uint8_t>(std::min<int32_t>(cell_distance, distance));
+				}
+			}
+		}
+		else {
+			updateWallDistance(x0, y0, x1, y1);
+		}
+	}
+
+	// Recompute the whole wall distance field, after the walls were written directly
+	void updateWallDistance()
+	{
+		updateWallDistance(0, 0, width, height);
+	}
+
+	/**
+	 * @brief Evaporate the markers
+	 *
+	 * @param stats If not null, receives the totals of the planes after the evaporation, summed during the sweep
+	 * of the active tiles. Lazy decay has no sweep and reads the active tiles for them.
+	 */
+	void update(float dt, const SimulationContext& context, FieldStats* stats = nullptr)
+	{
+		if (lazy_decay) {
+			// Rates are those of the latest step, they are expected to stay constant during a run
+			getDecayRates(dt, context, decay_rate);
+			++current_step;
+			if (stats) {
+				computeStats(*stats);
+			}
+			return;
+		}
+
+		// Intensity removed from each channel at this step
+		float rates[MODE_COUNT];
+		getDecayRates(dt, context, rates);
+		IntensityStorage::Decay decays[MODE_COUNT];
+		for (uint32_t m(0); m < MODE_COUNT; ++m) {
+			decays[m] = IntensityStorage::getDecay(rates[m], decay_carry[m]);
+		}
+		if (stats) {
+			*stats = FieldStats();
+			stats->cell_count = getCellCount();
+		}
+		// Update the intensities of the runs of consecutive active tiles, the totals are summed while the cells
+		// of the run are still in the caches
+		const uint64_t cell_count = getStorageSize();
+		const uint64_t tile_count = getActiveTileCount();
+		uint64_t tile = 0;
+		while (tile < tile_count) {
+			if (!active_tiles[tile >> 6]) {
+				tile = (tile | 63) + 1;
+				continue;
+			}
+			if (!isTileActive(tile)) {
+				++tile;
+				continue;
+			}
+			// Runs are kept short enough for their emptiness check to read cached cells
+			uint64_t run_end = tile + 1;
+			while (run_end < tile_count && run_end - tile < MAX_DECAY_RUN && isTileActive(run_end)) {
+				++run_end;
+			}
+			const uint64_t run_begin_cell = tile << ACTIVE_TILE_SHIFT;
+			const uint64_t run_end_cell = std::min(run_end << ACTIVE_TILE_SHIFT, cell_count);
+			decayCells(run_begin_cell, run_end_cell, decays);
+			if (stats) {
+				addStats(run_begin_cell, run_end_cell, *stats);
+			}
+			for (; tile < run_end; ++tile) {
+				setTileActive(tile, !isTileEmpty(tile));
+			}
+		}
+	}
+
+	/**
+	 * @brief Set the evaporation carries to the ones of steps updates with the rates of a context
+	 *
+	 * A copy of a grid updated with other rates then evaporates as if it had been updated with its own rates from
+	 * the start, the carries of the fixed point planes depend on the rates of all the previous steps.
+	 */
+	void replayDecayCarry(float dt, const SimulationContext& context, uint32_t steps)
+	{
+		float rates[MODE_COUNT];
+		getDecayRates(dt, context, rates);
+		for (uint32_t m(0); m < MODE_COUNT; ++m) {
+			decay_carry[m] = 0.0;
+			for (uint32_t step(0); step < steps; ++step) {
+				IntensityStorage::getDecay(rates[m], decay_carry[m]);
+			}
 		}
 	}
 
 	bool isOnFood(sf::Vector2f pos) const
 	{
-		return getCst(pos).food;
+		return food[getIndex(pos)];
 	}
 
 	void pickFood(sf::Vector2f pos)
 	{
-		get(pos).pick();
+		pickFood(getIndex(pos));
+	}
+
+	void pickFood(uint64_t index)
+	{
+		uint32_t& quantity = food[index];
+		quantity -= bool(quantity);
+		// Without the grid sweep the food marker of a depleted cell has to be removed right away
+		const uint8_t food_bit = getModeBit(Mode::ToFood);
+		if (lazy_decay && !quantity && (permanent[index] & food_bit)) {
+			refresh(index);
+			permanent[index] &= ~food_bit;
+			intensity[to<uint32_t>(Mode::ToFood)][index] = IntensityStorage::encode(0.0f);
+		}
 	}
 
 	HitPoint getFirstHit(sf::Vector2f p, sf::Vector2f d, float max_dist) const
 	{
 		HitPoint intersection;
 		sf::Vector2i cell_p = getCellCoords(p);
+		// The walk only enters cells next to the ones the segment crosses, the distance to the walls tells if
+		// one of them can be a wall. +2 since the position can be anywhere in its cell.
+		if (checkCoords(cell_p) && max_dist < float(MAX_WALL_DISTANCE * cell_size)) {
+			const int32_t reach = to<int32_t>(max_dist / float(cell_size)) + 2;
+			if (wall_distance[getIndexFromCoords(cell_p)] > reach) {
+				return intersection;
+			}
+		}
 		const sf::Vector2i step(d.x < 0.0f ? -1 : 1, d.y < 0.0f ? -1 : 1);
 		const sf::Vector2f inv_d(1.0f / d.x, 1.0f / d.y);
 		const float t_dx = std::abs(float(cell_size) * inv_d.x);
@@ -148,9 +424,9 @@ struct WorldGrid : public Grid<WorldCell>
 				return intersection;
 			}
 			else {
-				const WorldCell& cell = getCst(cell_p);
-				if (cell.wall) {
-					intersection.cell = &cell;
+				const uint64_t index = getIndexFromCoords(cell_p);
+				if (wall[index]) {
+					intersection.cell = WorldCell(*this, index);
 					intersection.normal = sf::Vector2f(to<float>(b), to<float>(!b));
 					return intersection;
 				}
@@ -158,4 +434,176 @@ struct WorldGrid : public Grid<WorldCell>
 		}
 		return intersection;
 	}
+
+private:
+	/**
+	 * @brief Recompute the wall distance of the cells of a rectangle
+	 *
+	 * Chebyshev distances are separable: the distance along the row to the nearest wall first, then the
+	 * nearest of these along the column.
+	 *
+	 * @param x0 First column of the rectangle, x1 is past its last one
+	 */
+	void updateWallDistance(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+	{
+		const int32_t row_y0 = std::max(y0 - MAX_WALL_DISTANCE, 0);
+		const int32_t row_y1 = std::min(y1 + MAX_WALL_DISTANCE, height);
+		const int32_t rect_width = x1 - x0;
+		// Distance along the row of the cells of the rectangle, extended by the range of the walls
+		std::vector<uint8_t> row_distance(to<uint64_t>(rect_width) * to<uint64_t>(row_y1 - row_y0));
+		for (int32_t y(row_y0); y < row_y1; ++y) {
+			for (int32_t x(x0); x < x1; ++x) {
+				int32_t distance = MAX_WALL_DISTANCE;
+				const int32_t begin = std::max(x - MAX_WALL_DISTANCE + 1, 0);
+				const int32_t end = std::min(x + MAX_WALL_DISTANCE, width);
+				for (int32_t wall_x(begin); wall_x < end; ++wall_x) {
+					if (wall[getIndexFromCoords(sf::Vector2i(wall_x, y))]) {
+						distance = std::min(distance, std::abs(wall_x - x));
+					}
+				}
+				row_distance[to<uint64_t>((y - row_y0) * rect_width + x - x0)] = static_cast<uint8_t>(distance);
+			}
+		}
+		for (int32_t y(y0); y < y1; ++y) {
+			for (int32_t x(x0); x < x1; ++x) {
+				int32_t distance = MAX_WALL_DISTANCE;
+				const int32_t begin = std::max(y - MAX_WALL_DISTANCE + 1, 0);
+				const int32_t end = std::min(y + MAX_WALL_DISTANCE, height);
+				for (int32_t row_y(begin); row_y < end; ++row_y) {
+					const int32_t row = row_distance[to<uint64_t>((row_y - row_y0) * rect_width + x - x0)];
+					distance = std::min(distance, std::max(row, std::abs(row_y - y)));
+				}
+				wall_distance[getIndexFromCoords(sf::Vector2i(x, y))] = static_cast<uint8_t>(distance);
+			}
+		}
+	}
+
+	// Lazy decay: write the decayed intensities of a cell back to the planes before modifying it
+	void refresh(uint64_t index)
+	{
+		if (!lazy_decay || last_update[index] == current_step) {
+			return;
+		}
+		for (uint32_t i(0); i < MODE_COUNT; ++i) {
+			intensity[i][index] = IntensityStorage::encode(getIntensity(index, static_cast<Mode>(i)));
+		}
+		last_update[index] = current_step;
+	}
+
+	void activate(uint64_t index)
+	{
+		active_tiles[index >> (ACTIVE_TILE_SHIFT + 6)] |= uint64_t(1) << ((index >> ACTIVE_TILE_SHIFT) & 63);
+	}
+
+	void setTileActive(uint64_t tile, bool active)
+	{
+		const uint64_t bit = uint64_t(1) << (tile & 63);
+		active_tiles[tile >> 6] = active ? (active_tiles[tile >> 6] | bit) : (active_tiles[tile >> 6] & ~bit);
+	}
+
+	// No marker and no intensity in the cells of a tile
+	bool isTileEmpty(uint64_t tile) const
+	{
+		const uint64_t begin = tile << ACTIVE_TILE_SHIFT;
+		const uint64_t end = std::min(begin + (1u << ACTIVE_TILE_SHIFT), getStorageSize());
+		// Bits of the values are or-ed by chunks, which vectorizes and stops early in live tiles
+		const uint64_t chunk = 64;
+		for (const std::vector<IntensityStorage::Value>& plane : intensity) {
+			for (uint64_t i(begin); i < end; i += chunk) {
+				uint32_t bits = 0;
+				for (uint64_t k(i); k < std::min(i + chunk, end); ++k) {
+					bits |= IntensityStorage::getBits(plane[k]);
+				}
+				if (bits) {
+					return false;
+				}
+			}
+		}
+		uint8_t bits = 0;
+		for (uint64_t i(begin); i < end; ++i) {
+			bits |= permanent[i];
+		}
+		return !bits;
+	}
+
+	// Lazy decay: totals of the planes as of the current step, the grid isn't swept otherwise
+	void computeStats(FieldStats& stats) const
+	{
+		stats = FieldStats();
+		stats.cell_count = getCellCount();
+		const uint64_t cell_count = getStorageSize();
+		const uint64_t tile_count = getActiveTileCount();
+		// Cells of inactive tiles are 0
+		for (uint64_t tile(0); tile < tile_count; ++tile) {
+			if (isTileActive(tile)) {
+				addStats(tile << ACTIVE_TILE_SHIFT, std::min((tile + 1) << ACTIVE_TILE_SHIFT, cell_count), stats);
+			}
+		}
+	}
+
+	// Add the intensities of the cells [begin, end) to the totals, lazy decay reads them through getIntensity
+	void addStats(uint64_t begin, uint64_t end, FieldStats& stats) const
+	{
+		for (uint32_t m(0); m < MODE_COUNT; ++m) {
+			const Mode mode = static_cast<Mode>(m);
+			const IntensityStorage::Value* plane = intensity[m].data();
+			double mass = stats.mass[m];
+			uint64_t covered = stats.covered_cells[m];
+			for (uint64_t i(begin); i < end; ++i) {
+				const float value = lazy_decay ? getIntensity(i, mode) : IntensityStorage::decode(plane[i]);
+				mass += value;
+				covered += value > 0.0f;
+			}
+			stats.mass[m] = mass;
+			stats.covered_cells[m] = covered;
+		}
+	}
+
+	// Intensity each channel loses per step
+	static void getDecayRates(float dt, const SimulationContext& context, float* rates)
+	{
+		rates[to<uint32_t>(Mode::ToHome)] = dt;
+		rates[to<uint32_t>(Mode::ToFood)] = dt;
+		rates[to<uint32_t>(Mode::ToHell)] = dt * context.hell_phermn_evpr_multi;
+		rates[to<uint32_t>(Mode::CounterPhr)] = dt * context.cntr_phermn_evpr_multi;
+	}
+
+	// Evaporation of the cells [begin, end)
+	void decayCells(uint64_t begin, uint64_t end, const IntensityStorage::Decay* decays)
+	{
+		decayChannel(Mode::ToHome, decays, begin, end);
+		decayChannel(Mode::ToHell, decays, begin, end);
+		decayChannel(Mode::CounterPhr, decays, begin, end);
+		// The food channel also removes the food markers of cells without food
+		const uint32_t food_index = to<uint32_t>(Mode::ToFood);
+		PheromoneDecay::decayFoodChannel(intensity[food_index].data() + begin, permanent.data() + begin, food.data() + begin, getModeBit(Mode::ToFood), decays[food_index], end - begin);
+	}
+
+	// Linear evaporation of one channel, permanent markers are kept and intensities can't go below 0
+	void decayChannel(Mode mode, const IntensityStorage::Decay* decays, uint64_t begin, uint64_t end)
+	{
+		const uint32_t mode_index = to<uint32_t>(mode);
+		PheromoneDecay::decayChannel(intensity[mode_index].data() + begin, permanent.data() + begin, getModeBit(mode), decays[mode_index], end - begin);
+	}
 };
+
+
+inline float WorldCell::getIntensity(Mode mode) const
+{
+	return grid->getIntensity(index, mode);
+}
+
+inline bool WorldCell::isPermanent(Mode mode) const
+{
+	return grid->permanent[index] & WorldGrid::getModeBit(mode);
+}
+
+inline uint32_t WorldCell::getFood() const
+{
+	return grid->food[index];
+}
+
+inline bool WorldCell::isWall() const
+{
+	return grid->wall[index];
+}
@@ -3,21 +3,44 @@
 #include "grid.hpp"
 #include "config.hpp"
 #include "world_grid.hpp"
+#include "field_renderer.hpp"
 
 
-struct WorldRenderer : public AsyncRenderer
+/**
+ * @brief Draws every cell as a textured quad, the vertices are updated in the background
+ *
+ * Each frame drawn requests the next update of the vertices. The update reads the grid by bands of columns with
+ * the state locked, the simulation can step between two bands.
+ */
+struct WorldRenderer : public AsyncRenderer, public FieldRenderer
 {
-	const Grid<WorldCell>& grid;
-	bool draw_markers;
+	static constexpr int32_t BAND_COLUMNS = 16;
 
-	WorldRenderer(Grid<WorldCell>& grid_, DoubleObject<sf::VertexArray>& target)
-		: AsyncRenderer(target)
+	DoubleObject<sf::VertexArray> va_markers;
+	const WorldGrid& grid;
+
+	explicit WorldRenderer(const WorldGrid& grid_, StateLock lock_state_ = StateLock())
+		: AsyncRenderer(va_markers)
+		, FieldRenderer(lock_state_)
 		, grid(grid_)
-		, draw_markers(true)
 	{
 		AsyncRenderer::start();
 	}
 
+	~WorldRenderer()
+	{
+		AsyncRenderer::stop();
+	}
+
+	void render(sf::RenderTarget& target, sf::RenderStates states) override
+	{
+		states.texture = &(*Conf::MARKER_TEXTURE);
+		mutex.lock();
+		target.draw(va_markers.getCurrent(), states);
+		mutex.unlock();
+		requestUpdate();
+	}
+
 	void initializeVertexArray(sf::VertexArray& va) override
 	{
 		va = sf::VertexArray(sf::Quads, grid.width * grid.height * 4);
@@ -38,45 +61,35 @@ struct WorldRenderer : public AsyncRenderer
 	void updateVertexArray() override
 	{
 		sf::VertexArray& va = vertex_array.getLast();
-		const sf::Vector3f to_home_color(Conf::TO_HOME_COLOR.r / 255.0f, Conf::TO_HOME_COLOR.g / 255.0f, Conf::TO_HOME_COLOR.b / 255.0f);
-		const sf::Vector3f to_food_color(Conf::TO_FOOD_COLOR.r / 255.0f, Conf::TO_FOOD_COLOR.g / 255.0f, Conf::TO_FOOD_COLOR.b / 255.0f);
-		const sf::Vector3f to_hell_color(Conf::TO_HELL_COLOR.r / 255.0f, Conf::TO_HELL_COLOR.g / 255.0f, Conf::TO_HELL_COLOR.b / 255.0f);
-		const sf::Vector3f counter_color(Conf::COUNTER_PHR_COLOR.r / 255.0f, Conf::COUNTER_PHR_COLOR.g / 255.0f, Conf::COUNTER_PHR_COLOR.b / 255.0f);
-
 		uint64_t i = 0;
-		const float cell_size = to<float>(grid.cell_size);
+		std::unique_lock<std::mutex> lock;
 		for (int32_t x(0); x < grid.width; x++) {
+			if (!(x % BAND_COLUMNS)) {
+				if (lock) {
+					lock.unlock();
+				}
+				lock = lockState();
+			}
 			for (int32_t y(0); y < grid.height; y++) {
-				const auto& cell = grid.getCst(sf::Vector2i(x, y));
-				sf::Color color = sf::Color::Black;
-				if (!cell.food && !cell.wall && draw_markers) {
-					const float intensity_factor = 0.27f;
-					const sf::Vector3f intensity_1_color = intensity_factor * to_home_color * cell.intensity[0];
-					const sf::Vector3f intensity_2_color = intensity_factor * to_food_color * cell.intensity[1];
-					const sf::Vector3f intensity_3_color = intensity_factor * to_hell_color * cell.intensity[2];
-					const sf::Vector3f intensity_4_color = intensity_factor * counter_color * cell.intensity[3];
-					const sf::Vector3f mixed_color(
-						std::min(255.0f, intensity_1_color.x + intensity_2_color.x + intensity_3_color.x + intensity_4_color.x),
-						std::min(255.0f, intensity_1_color.y + intensity_2_color.y + intensity_3_color.y + intensity_4_color.y),
-						std::min(255.0f, intensity_1_color.z + intensity_2_color.z + intensity_3_color.z + intensity_4_color.z)
-					);
-					color = sf::Color(sf::Color(to<uint8_t>(mixed_color.x), to<uint8_t>(mixed_color.y), to<uint8_t>(mixed_color.z)));
+				const WorldCell cell = grid.getCst(sf::Vector2i(x, y));
+				const uint32_t food = cell.getFood();
+				const bool wall = cell.isWall();
+				const sf::Color color = getCellColor(cell);
+				if (!food && !wall && draw_markers) {
 					const float offset = 32.0f;
 					va[4 * i + 0].texCoords = sf::Vector2f(offset, offset);
 					va[4 * i + 1].texCoords = sf::Vector2f(100.0f - offset, offset);
 					va[4 * i + 2].texCoords = sf::Vector2f(100.0f - offset, 100.0f - offset);
 					va[4 * i + 3].texCoords = sf::Vector2f(offset, 100.0f - offset);
 				}
-				else if (cell.food) {
-					color = Conf::FOOD_COLOR;
+				else if (food) {
 					const float offset = 4.0f;
 					va[4 * i + 0].texCoords = sf::Vector2f(100.0f + offset, offset);
 					va[4 * i + 1].texCoords = sf::Vector2f(200.0f - offset, offset);
 					va[4 * i + 2].texCoords = sf::Vector2f(200.0f - offset, 100.0f - offset);
 					va[4 * i + 3].texCoords = sf::Vector2f(100.0f + offset, 100.0f - offset);
 				}
-				else if (cell.wall) {
-					color = Conf::WALL_COLOR;
+				else if (wall) {
 					const float offset = 4.0f;
 					va[4 * i + 0].texCoords = sf::Vector2f(200.0f + offset, offset);
 					va[4 * i + 1].texCoords = sf::Vector2f(300.0f - offset, offset);
@@ -1,7 +1,8 @@
 #include "display_manager.hpp"
 
 
-DisplayManager::DisplayManager(sf::RenderTarget& target, sf::RenderWindow& window, World& world, Colony& colony)
+DisplayManager::DisplayManager(sf::RenderTarget& target, sf::RenderWindow& window, World& world, Colony& colony,
+                               FieldRenderer& world_renderer, ColonyRenderer& colony_renderer)
 	: m_window(window)
 	, m_target(target)
 	, m_zoom(1.0f)
@@ -13,6 +14,8 @@ DisplayManager::DisplayManager(sf::RenderTarget& target, sf::RenderWindow& windo
 	, debug_mode(false)
 	, m_world(world)
 	, m_colony(colony)
+	, m_world_renderer(world_renderer)
+	, m_colony_renderer(colony_renderer)
 	, clic(false)
 	, m_mouse_button_pressed(false)
 	, pause(false)
@@ -65,11 +68,11 @@ void DisplayManager::draw()
 	sf::RenderStates rs = rs_ground;
 
 	// Render markers
-	m_world.renderMarkers(m_target, rs_ground);
+	m_world_renderer.render(m_target, rs_ground);
 
 	// Render ants
 	if (render_ants) {
-		m_colony.render(m_target, rs);
+		m_colony_renderer.render(m_target, rs);
 	}
 
 	const float size = m_colony.size;
@@ -108,7 +111,7 @@ void DisplayManager::processEvents()
 				}
 			}
 			else if ((event.key.code == sf::Keyboard::A)) render_ants = !render_ants;
-			else if ((event.key.code == sf::Keyboard::M)) m_world.renderer.draw_markers = !m_world.renderer.draw_markers;
+			else if ((event.key.code == sf::Keyboard::M)) m_world_renderer.draw_markers = !m_world_renderer.draw_markers;
 			else if ((event.key.code == sf::Keyboard::W)) {
 				wall_mode = !wall_mode;
 				if (wall_mode) {
@@ -121,11 +124,7 @@ void DisplayManager::processEvents()
 				m_offsetY = m_windowOffsetY;
 				m_zoom = 1.0f;
 			}
-			else if ((event.key.code == sf::Keyboard::S))
-			{
-				speed_mode = !speed_mode;
-				m_window.setFramerateLimit(speed_mode ? 0 : 60);
-			}
+			else if ((event.key.code == sf::Keyboard::S)) speed_mode = !speed_mode;
 			break;
 		case sf::Event::MouseWheelMoved:
 			// this is an amazing zoom
@@ -0,0 +1,96 @@
+#include "food_map.hpp"
+
+#ifndef ANTSIM_HEADLESS
+
+#include <SFML/Graphics.hpp>
+
+bool FoodMap::loadFromFile(const std::string& path)
+{
+	sf::Image image;
+	if (!image.loadFromFile(path)) {
+		return false;
+	}
+	width = image.getSize().x;
+	height = image.getSize().y;
+	pixels.resize(width * height);
+	for (uint32_t y(0); y < height; ++y) {
+		for (uint32_t x(0); x < width; ++x) {
+			const sf::Color color = image.getPixel(x, y);
+			pixels[x + y * width] = { color.r, color.g, color.b };
+		}
+	}
+	return true;
+}
+
+#else
+
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	uint32_t readU32(const std::vector<uint8_t>& data, size_t offset)
+	{
+		return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (uint32_t(data[offset + 3]) << 24);
+	}
+
+	uint16_t readU16(const std::vector<uint8_t>& data, size_t offset)
+	{
+		return static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+	}
+}
+
+bool FoodMap::loadFromFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	const size_t file_header_size = 14;
+	if (data.size() < file_header_size + 40 || data[0] != 'B' || data[1] != 'M') {
+		return false;
+	}
+
+	const uint32_t pixels_offset = readU32(data, 10);
+	const uint32_t info_header_size = readU32(data, 14);
+	const int32_t raw_width = static_cast<int32_t>(readU32(data, 18));
+	const int32_t raw_height = static_cast<int32_t>(readU32(data, 22));
+	const uint16_t bits_per_pixel = readU16(data, 28);
+	const uint32_t compression = readU32(data, 30);
+	// Only uncompressed (BI_RGB) and 32 bits BI_BITFIELDS images are supported
+	if (compression != 0 && !(compression == 3 && bits_per_pixel == 32)) {
+		return false;
+	}
+	if (bits_per_pixel != 8 && bits_per_pixel != 24 && bits_per_pixel != 32) {
+		return false;
+	}
+
+	// Rows are stored bottom-up unless the height is negative
+	const bool bottom_up = raw_height > 0;
+	width = static_cast<uint32_t>(raw_width);
+	height = static_cast<uint32_t>(bottom_up ? raw_height : -raw_height);
+	const size_t row_size = ((bits_per_pixel * size_t(width) + 31) / 32) * 4;
+	if (pixels_offset + row_size * height > data.size()) {
+		return false;
+	}
+
+	const size_t palette_offset = file_header_size + info_header_size;
+	pixels.resize(size_t(width) * height);
+	for (uint32_t y(0); y < height; ++y) {
+		const size_t row = pixels_offset + (bottom_up ? height - 1 - y : y) * row_size;
+		for (uint32_t x(0); x < width; ++x) {
+			size_t bgr = row + x * (bits_per_pixel / 8);
+			if (bits_per_pixel == 8) {
+				bgr = palette_offset + 4 * data[row + x];
+				if (bgr + 2 >= data.size()) {
+					return false;
+				}
+			}
+			pixels[x + y * width] = { data[bgr + 2], data[bgr + 1], data[bgr] };
+		}
+	}
+	return true;
+}
+
+#endif
@@ -1,11 +1,19 @@
-#include <SFML/Graphics.hpp>
 #include <vector>
 #include <list>
 #include <fstream>
 #include "colony.hpp"
+#include "simulation_context.hpp"
 #include "config.hpp"
-#include "display_manager.hpp"
+#include "food_map.hpp"
 #include "tinyxml2.h"
+#ifndef ANTSIM_HEADLESS
+#include <SFML/Graphics.hpp>
+#include "display_manager.hpp"
+#include "world_renderer.hpp"
+#include "field_texture_renderer.hpp"
+#include "colony_renderer.hpp"
+#include "simulation_thread.hpp"
+#endif
 
 #include <stdio.h> // for sprintf()
 
@@ -13,6 +21,21 @@
 #include <string>	// for std::string
 #include <ctime>
 #include <sstream>
+#include <mutex>
+#include <algorithm>
+#include <memory>
+#include "worker_pool.hpp"
+#include "number_generator.hpp"
+#include "results_file.hpp"
+#include "metrics.hpp"
+#include "run_summary.hpp"
+#include "parameter_sweep.hpp"
+#include "checkpoint.hpp"
+#include "pheromone_decay.hpp"
+#include <map>
+#include <atomic>
+#include <future>
+#include <random>
 
 /****************************************************************************************
 ************************ CHANGE THESE PARAMETERS FOR TRIALS ************************
@@ -20,47 +43,83 @@
 /*
  * @param sim_config.gui_display:: Do you want GUI? If set to true, you can see the simulation
  * @param sim_config.gui_fullscreen:: Do you want GUI to be fullscreen? Useful to turn off since some display configuration may crash at fullscreen
+ * @param sim_config.gui_steps_per_frame:: Steps simulated for each frame shown by the GUI, outside of fast forward
+ * @param sim_config.gui_field_texture:: Draw the field as a texture with a pixel per cell instead of a textured quad per cell
  * @param sim_config.sim_steps:: Number of steps of simulation (Will not be in effect for GUI)
  * @param sim_config.sim_iterations:: Run the same configured iteration these number of times
+ * @param sim_config.sim_threads:: Number of trials run concurrently (0 uses all hardware threads)
+ * @param sim_config.sim_seed:: Seed of the random numbers, every iteration and trunk of the sweep derives its own seed from it
+ * @param sim_config.sim_ant_threads:: Threads updating the ants of each trial (0 keeps the sequential update where ants see each other's writes immediately)
+ * @param sim_config.sim_ant_sort_period:: Steps between two sorts of the ants by position, for the locality of their grid accesses (0 never sorts, requires ant threads otherwise)
+ * @param sim_config.sim_lazy_decay:: Compute the pheromone evaporation when cells are read instead of sweeping the grid every step
+ * @param sim_config.sim_grid_layout:: Order of the cells in memory, row major or in tiles that keep the cells an ant senses close
+ * @param sim_config.sim_exact_marker_intensity:: Compute the intensity of every marker instead of reading it from tables, to validate them
+ * @param sim_config.sim_decay_kernel:: Evaporation kernels forced instead of the fastest ones of the CPU, to compare them (empty keeps the fastest)
+ * Numeric parameters accept a single value, a space separated list of values or a start:stop:step range, every
+ * combination of the values is a point of the sweep. The members hold the values of the point being simulated.
+ *
  * @param sim_config.total_ant_number:: Total number of ants in the simulation
  * @param sim_config.malicious_fraction:: Probability of an ant being malicious (fraction of ants being malicious)
  * @param sim_config.malicious_timer_wait:: Delay after which the attack is launched
  * @param sim_config.malicious_focus::  Should the attack be focused towards food
  * @param sim_config.malicious_tracing_pattern::   Should malicious ants trace food pheromone or roam randomly
  * @param sim_config.patience_activation:: Will the ants secrete counter pheromone?
- * @param sim_config.patience_refill_period_vec:: Period(s) needed for counter pheromone to return to the max value
+ * @param sim_config.patience_refill_period:: Period needed for counter pheromone to return to the max value
  * @param sim_config.patience_evaporation_mult:: Multiplier for the evaporation rate of the fake food pheromone
- * @param sim_config.patience_max_val_vec::	What is(are) the maximum value(s) for the counter pheromone?
+ * @param sim_config.patience_max:: Maximum value for the counter pheromone
  * @param sim_config.malicious_intensity_mult:: Multiplier for the intensity of the fake food pheromone
  * @param sim_config.malicious_evaporation_mult:: Multiplier for the evaporation of the fake food pheromone
+ * @param sim_config.binary_output_path:: Results file receiving all the runs instead of one CSV file per run
+ * @param sim_config.metrics:: Columns of the results, the 4 food metrics by default
+ * @param sim_config.metrics_interval:: Steps between two samples of the metrics (0 records 100 samples per run)
+ * @param sim_config.summary_activation:: Write the statistics of the iterations of each configuration
+ * @param sim_config.summary_keep_iterations:: Also write the run of every iteration when the summary is active
+ * @param sim_config.sweep:: Parameters given several values
+ * @param sim_config.checkpoint_period:: Steps between two checkpoints of a trial (0 disables the checkpoints)
+ * @param sim_config.checkpoint_prefix:: Prefix of the checkpoint files, completed with the name of the trial
+ * @param sim_config.checkpoint_resume:: Resume the trials from their checkpoint when it exists
+ * @param sim_config.checkpoint_fork_path:: Checkpoint all the trials start from instead of step 0, empty to start from scratch
  */
 struct SimulationConfiguration
 {
 	SimulationConfiguration(){};
 
-	void ParsePatienceRefillPeriodVec(const std::string &str_arr)
+	/**
+	 * @brief Parse the values of a numeric parameter, it becomes an axis of the sweep if it has several values
+	 *
+	 * @param name Name of the parameter in the results
+	 * @param str_arr Value, list or range of the parameter
+	 * @param apply Sets a value of the parameter in a configuration
+	 * @param post_attack Is the parameter without effect before the malicious ants attack ?
+	 */
+	void ParseSweptParameter(const std::string &name, const char *str_arr, std::function<void(SimulationConfiguration &, double)> apply, bool post_attack = false)
 	{
-		std::istringstream ss(str_arr);
-		float val;
-		while (ss >> val)
+		if (!str_arr)
 		{
-			patience_refill_period_vec.push_back(val);
+			throw std::invalid_argument("Missing value of " + name);
+		}
+		const std::vector<double> values = ParameterSweep<SimulationConfiguration>::parseValues(str_arr);
+		apply(*this, values.front());
+		if (values.size() > 1)
+		{
+			sweep.addAxis(name, values, apply, post_attack);
 		}
-
-		patience_refill_period_itr = patience_refill_period_vec.begin();
 	};
 
-	void ParseMaxPatienceVec(const std::string &str_arr)
+	// Value of a numeric setting that can't be swept
+	static double ParseSingleParameter(const std::string &name, const char *str)
 	{
-		std::istringstream ss(str_arr);
-		float val;
-		while (ss >> val)
+		if (!str)
 		{
-			patience_max_val_vec.push_back(val);
+			throw std::invalid_argument("Missing value of " + name);
 		}
-
-		patience_max_val_itr = patience_max_val_vec.begin();
-	};
+		const std::vector<double> values = ParameterSweep<SimulationConfiguration>::parseValues(str);
+		if (values.size() > 1)
+		{
+			throw std::invalid_argument(name + " takes a single value, it can't be swept");
+		}
+		return values.front();
+	}
 
 	void ParseTracingPattern(const std::string &str)
 	{
@@ -82,25 +141,73 @@ struct SimulationConfiguration
 		}
 	};
 
+	void ParseFieldRenderer(const std::string &str)
+	{
+		if (str == "vertices")
+		{
+			gui_field_texture = false;
+		}
+		else if (str == "texture")
+		{
+			gui_field_texture = true;
+		}
+		else
+		{
+			throw std::invalid_argument("Invalid field renderer!");
+		}
+	}
+
+	void ParseGridLayout(const std::string &str)
+	{
+		if (str == "row_major")
+		{
+			sim_grid_layout = GridLayout::RowMajor;
+		}
+		else if (str == "tiled")
+		{
+			sim_grid_layout = GridLayout::Tiled;
+		}
+		else
+		{
+			throw std::invalid_argument("Invalid grid layout!");
+		}
+	};
+
 	bool gui_display = false;
 
 	bool gui_fullscreen = false;
 
+	uint32_t gui_steps_per_frame = 1;
+
+	bool gui_field_texture = false;
+
 	int sim_steps = 50000;
 
 	int sim_iterations = 100;
 
-	int total_ant_number = 1024;
+	uint32_t sim_threads = 0;
 
-	bool patience_activation = false;
+	uint64_t sim_seed = 0;
+
+	uint32_t sim_ant_threads = 0;
+
+	uint32_t sim_ant_sort_period = 0;
+
+	bool sim_lazy_decay = false;
 
-	std::vector<float> patience_max_val_vec;
+	GridLayout sim_grid_layout = GridLayout::RowMajor;
 
-	std::vector<float> patience_refill_period_vec;
+	bool sim_exact_marker_intensity = false;
 
-	std::vector<float>::const_iterator patience_max_val_itr;
+	std::string sim_decay_kernel;
 
-	std::vector<float>::const_iterator patience_refill_period_itr;
+	int total_ant_number = 1024;
+
+	bool patience_activation = false;
+
+	float patience_max = 50.0;
+
+	float patience_refill_period = 5.0;
 
 	float patience_evaporation_mult = 1.0;
 
@@ -118,32 +225,91 @@ struct SimulationConfiguration
 
 	std::string csv_prefix;
 
+	// Single binary results file replacing the CSV files, empty to write CSV files
+	std::string binary_output_path;
+
+	std::vector<Metric> metrics;
+
+	uint32_t metrics_interval = 0;
+
+	ParameterSweep<SimulationConfiguration> sweep;
+
+	uint32_t checkpoint_period = 0;
+
+	std::string checkpoint_prefix;
+
+	bool checkpoint_resume = false;
+
+	std::string checkpoint_fork_path;
+
+	bool summary_activation = false;
+
+	bool summary_keep_iterations = true;
+
 	std::string food_map_path;
 };
 
-SimulationConfiguration sim_config; // define as a global variable
+/**
+ * @brief Identifies one of the independent trials of a sweep, the parameters of its point are in its configuration
+ *
+ * @param iteration Index of the repeated trial
+ * @param point Index of the point of the sweep, shared by the iterations
+ */
+struct TrialSpec
+{
+	int iteration;
+	int point;
+};
+
+// Name of the configuration of a trial, shared by all its iterations
+std::string getConfigurationName(const SimulationConfiguration &config)
+{
+	std::string DISPLAY_GUI_string = "_DISPLAY_GUI-" + std::to_string(config.gui_display);
+	std::string SIMULATION_STEPS_string = "_SIM_STEPS-" + std::to_string(config.sim_steps);
+	std::string SIMULATION_ITERATIONS_string = "_SIM_ITERS-" + std::to_string(config.sim_iterations);
+	std::string malicious_fraction_string = "_mal_frac-" + std::to_string(config.malicious_fraction);
+	std::string malicious_timer_wait_string = "_mal_delay-" + std::to_string(config.malicious_timer_wait);
+	std::string malicious_ants_focus_string = "_mal_ants_focus-" + std::to_string(config.malicious_focus);
+	std::string ant_tracing_pattern_string = "_ant_tracing-" + std::to_string(config.malicious_tracing_pattern);
+	std::string counter_pheromone_string = "_ctr_pherm-" + std::to_string(config.patience_activation);
+	std::string hell_phermn_intensity_multiplier_string = "_hell_phermn_intens-" + std::to_string(config.malicious_intensity_mult);
+	std::string hell_phermn_evpr_multi_string = "_hell_phermn_evpr-" + std::to_string(config.malicious_evaporation_mult);
+	std::string dilusion_max_string = "_dil_max-" + std::to_string(config.patience_max);
+	std::string dilusion_increment_string = "_dil_incr-" + std::to_string(config.patience_refill_period);
+	// Only named when swept, so the names of the other runs don't change
+	std::string ants_string = config.sweep.hasAxis("ants") ? "_ants-" + std::to_string(config.total_ant_number) : "";
+
+	return SIMULATION_STEPS_string + SIMULATION_ITERATIONS_string + malicious_fraction_string + malicious_timer_wait_string + malicious_ants_focus_string + ant_tracing_pattern_string + counter_pheromone_string + hell_phermn_intensity_multiplier_string + hell_phermn_evpr_multi_string + dilusion_max_string + dilusion_increment_string + ants_string;
+}
+
+std::string getExperimentSpecificName(const SimulationConfiguration &config, const TrialSpec &trial)
+{
+	std::string iteration_string = "_iter-" + std::to_string(trial.iteration);
+
+	return getConfigurationName(config) + iteration_string;
+}
 
-std::string getExperimentSpecificName(int iteration)
+// Same parameters as the CSV file names
+void addRunParameters(const SimulationConfiguration &config, const TrialSpec &trial, RunSeries &run)
 {
-	std::string DISPLAY_GUI_string = "_DISPLAY_GUI-" + std::to_string(sim_config.gui_display);
-	std::string SIMULATION_STEPS_string = "_SIM_STEPS-" + std::to_string(sim_config.sim_steps);
-	std::string SIMULATION_ITERATIONS_string = "_SIM_ITERS-" + std::to_string(sim_config.sim_iterations);
-	std::string malicious_fraction_string = "_mal_frac-" + std::to_string(sim_config.malicious_fraction);
-	std::string malicious_timer_wait_string = "_mal_delay-" + std::to_string(sim_config.malicious_timer_wait);
-	std::string malicious_ants_focus_string = "_mal_ants_focus-" + std::to_string(sim_config.malicious_focus);
-	std::string ant_tracing_pattern_string = "_ant_tracing-" + std::to_string(sim_config.malicious_tracing_pattern);
-	std::string counter_pheromone_string = "_ctr_pherm-" + std::to_string(sim_config.patience_activation);
-	std::string hell_phermn_intensity_multiplier_string = "_hell_phermn_intens-" + std::to_string(sim_config.malicious_intensity_mult);
-	std::string hell_phermn_evpr_multi_string = "_hell_phermn_evpr-" + std::to_string(sim_config.malicious_evaporation_mult);
-	std::string dilusion_max_string = "_dil_max-" + std::to_string(*sim_config.patience_max_val_itr);
-	std::string dilusion_increment_string = "_dil_incr-" + std::to_string(*sim_config.patience_refill_period_itr);
-	std::string iteration_string = "_iter-" + std::to_string(iteration);
-
-	return SIMULATION_STEPS_string + SIMULATION_ITERATIONS_string + malicious_fraction_string + malicious_timer_wait_string + malicious_ants_focus_string + ant_tracing_pattern_string + counter_pheromone_string + hell_phermn_intensity_multiplier_string + hell_phermn_evpr_multi_string + dilusion_max_string + dilusion_increment_string + iteration_string;
+	run.addParameter("SIM_STEPS", config.sim_steps);
+	run.addParameter("SIM_ITERS", config.sim_iterations);
+	run.addParameter("mal_frac", config.malicious_fraction);
+	run.addParameter("mal_delay", config.malicious_timer_wait);
+	run.addParameter("mal_ants_focus", config.malicious_focus);
+	run.addParameter("ant_tracing", config.malicious_tracing_pattern);
+	run.addParameter("ctr_pherm", config.patience_activation);
+	run.addParameter("hell_phermn_intens", config.malicious_intensity_mult);
+	run.addParameter("hell_phermn_evpr", config.malicious_evaporation_mult);
+	run.addParameter("dil_max", config.patience_max);
+	run.addParameter("dil_incr", config.patience_refill_period);
+	run.addParameter("ants", config.total_ant_number);
+	run.addParameter("iter", trial.iteration);
 }
 
-void loadUserConf()
+SimulationConfiguration loadUserConf()
 {
+	SimulationConfiguration config;
 	tinyxml2::XMLDocument doc;
 
 	// Populate simulation parameters only if file exists
@@ -159,75 +325,179 @@ void loadUserConf()
 
 		// Get GUI settings
 		tinyxml2::XMLElement *gui_element = root->FirstChildElement("gui");
-		sim_config.gui_display = gui_element->FirstChildElement("activate")->BoolAttribute("bool");
-		sim_config.gui_fullscreen = gui_element->FirstChildElement("fullscreen")->BoolAttribute("bool");
+		config.gui_display = gui_element->FirstChildElement("activate")->BoolAttribute("bool");
+		config.gui_fullscreen = gui_element->FirstChildElement("fullscreen")->BoolAttribute("bool");
+		if (tinyxml2::XMLElement *steps_per_frame_element = gui_element->FirstChildElement("steps_per_frame"))
+		{
+			config.gui_steps_per_frame = steps_per_frame_element->UnsignedAttribute("int");
+			if (!config.gui_steps_per_frame)
+			{
+				throw std::invalid_argument("steps_per_frame must be at least 1");
+			}
+		}
+		if (tinyxml2::XMLElement *field_renderer_element = gui_element->FirstChildElement("field_renderer"))
+		{
+			field_renderer_element->QueryStringAttribute("type", &temp_str);
+			config.ParseFieldRenderer(std::string(temp_str));
+		}
 
 		// Get simulation settings
 		tinyxml2::XMLElement *sim_element = root->FirstChildElement("simulation");
 		sim_element->FirstChildElement("map")->QueryStringAttribute("path", &temp_str);
-		sim_config.food_map_path = std::string(temp_str);
-		sim_config.sim_steps = sim_element->FirstChildElement("steps")->IntAttribute("int");
-		sim_config.sim_iterations = sim_element->FirstChildElement("iterations")->IntAttribute("int");
+		config.food_map_path = std::string(temp_str);
+		config.sim_steps = sim_element->FirstChildElement("steps")->IntAttribute("int");
+		config.sim_iterations = sim_element->FirstChildElement("iterations")->IntAttribute("int");
+		if (tinyxml2::XMLElement *threads_element = sim_element->FirstChildElement("threads"))
+		{
+			config.sim_threads = threads_element->UnsignedAttribute("int");
+		}
+		if (tinyxml2::XMLElement *seed_element = sim_element->FirstChildElement("seed"))
+		{
+			config.sim_seed = seed_element->Unsigned64Attribute("int");
+		}
+		else
+		{
+			std::random_device rd;
+			config.sim_seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+			std::cout << "No seed in the configuration, using seed " << config.sim_seed << std::endl;
+		}
+		if (tinyxml2::XMLElement *ant_threads_element = sim_element->FirstChildElement("ant_threads"))
+		{
+			config.sim_ant_threads = ant_threads_element->UnsignedAttribute("int");
+		}
+		if (tinyxml2::XMLElement *ant_sort_period_element = sim_element->FirstChildElement("ant_sort_period"))
+		{
+			config.sim_ant_sort_period = ant_sort_period_element->UnsignedAttribute("int");
+			// The sequential update outcome depends on the order of the ants, only the step synchronous one can sort them
+			if (config.sim_ant_sort_period && !config.sim_ant_threads)
+			{
+				throw std::invalid_argument("ant_sort_period requires ant_threads");
+			}
+		}
+		if (tinyxml2::XMLElement *lazy_decay_element = sim_element->FirstChildElement("lazy_decay"))
+		{
+			config.sim_lazy_decay = lazy_decay_element->BoolAttribute("bool");
+		}
+		if (tinyxml2::XMLElement *grid_layout_element = sim_element->FirstChildElement("grid_layout"))
+		{
+			grid_layout_element->QueryStringAttribute("type", &temp_str);
+			config.ParseGridLayout(std::string(temp_str));
+		}
+		if (tinyxml2::XMLElement *exact_marker_intensity_element = sim_element->FirstChildElement("exact_marker_intensity"))
+		{
+			config.sim_exact_marker_intensity = exact_marker_intensity_element->BoolAttribute("bool");
+		}
+		if (tinyxml2::XMLElement *decay_kernel_element = sim_element->FirstChildElement("decay_kernel"))
+		{
+			decay_kernel_element->QueryStringAttribute("type", &temp_str);
+			config.sim_decay_kernel = std::string(temp_str);
+			if (!PheromoneDecay::setImplementation(config.sim_decay_kernel))
+			{
+				throw std::invalid_argument("Decay kernel " + config.sim_decay_kernel + " is unknown or not supported by this CPU");
+			}
+		}
 
 		// Get total ant settings
 		tinyxml2::XMLElement *total_ants_element = root->FirstChildElement("total_ants");
-		sim_config.total_ant_number = total_ants_element->FirstChildElement("number")->IntAttribute("int");
-		Conf::ANTS_COUNT = sim_config.total_ant_number; // @todo: this shouldn't really be done this way, but the config file has been hardcoded
+		config.ParseSweptParameter("ants", total_ants_element->FirstChildElement("number")->Attribute("int"), [](SimulationConfiguration &c, double v) { c.total_ant_number = static_cast<int>(v); });
 
 		// Get patience/cautionary settings
 		tinyxml2::XMLElement *patience_element = root->FirstChildElement("patience");
-		sim_config.patience_activation = patience_element->FirstChildElement("activate")->BoolAttribute("bool");
-		patience_element->FirstChildElement("refill_period_range")->QueryStringAttribute("str_arr", &temp_str);
-		sim_config.ParsePatienceRefillPeriodVec(std::string(temp_str));
-		patience_element->FirstChildElement("max_range")->QueryStringAttribute("str_arr", &temp_str);
-		sim_config.ParseMaxPatienceVec(std::string(temp_str));
-		sim_config.patience_evaporation_mult = patience_element->FirstChildElement("pheromone_evaporation_multiplier")->FloatAttribute("float");
+		config.patience_activation = patience_element->FirstChildElement("activate")->BoolAttribute("bool");
+		// Declared max first so the refill period varies the fastest, as in the original nested loops
+		config.ParseSweptParameter("dil_max", patience_element->FirstChildElement("max_range")->Attribute("str_arr"), [](SimulationConfiguration &c, double v) { c.patience_max = static_cast<float>(v); });
+		config.ParseSweptParameter("dil_incr", patience_element->FirstChildElement("refill_period_range")->Attribute("str_arr"), [](SimulationConfiguration &c, double v) { c.patience_refill_period = static_cast<float>(v); });
+		config.patience_evaporation_mult = static_cast<float>(SimulationConfiguration::ParseSingleParameter("patience pheromone_evaporation_multiplier", patience_element->FirstChildElement("pheromone_evaporation_multiplier")->Attribute("float")));
 
 		// Get malicious ants settings
 		tinyxml2::XMLElement *malicious_element = root->FirstChildElement("malicious_ants");
-		sim_config.malicious_fraction = malicious_element->FirstChildElement("fraction")->FloatAttribute("float");
-		sim_config.malicious_focus = malicious_element->FirstChildElement("focus")->BoolAttribute("bool");
-		sim_config.malicious_timer_wait = malicious_element->FirstChildElement("timer")->IntAttribute("int");
-		sim_config.malicious_intensity_mult = malicious_element->FirstChildElement("pheromone_intensity_multiplier")->FloatAttribute("float");
-		sim_config.malicious_evaporation_mult = malicious_element->FirstChildElement("pheromone_evaporation_multiplier")->FloatAttribute("float");
+		config.ParseSweptParameter("mal_frac", malicious_element->FirstChildElement("fraction")->Attribute("float"), [](SimulationConfiguration &c, double v) { c.malicious_fraction = static_cast<float>(v); });
+		config.malicious_focus = malicious_element->FirstChildElement("focus")->BoolAttribute("bool");
+		config.ParseSweptParameter("mal_delay", malicious_element->FirstChildElement("timer")->Attribute("int"), [](SimulationConfiguration &c, double v) { c.malicious_timer_wait = static_cast<int>(v); }, true);
+		config.ParseSweptParameter("hell_phermn_intens", malicious_element->FirstChildElement("pheromone_intensity_multiplier")->Attribute("float"), [](SimulationConfiguration &c, double v) { c.malicious_intensity_mult = static_cast<float>(v); }, true);
+		config.ParseSweptParameter("hell_phermn_evpr", malicious_element->FirstChildElement("pheromone_evaporation_multiplier")->Attribute("float"), [](SimulationConfiguration &c, double v) { c.malicious_evaporation_mult = static_cast<float>(v); }, true);
 		malicious_element->FirstChildElement("tracing_pattern")->QueryStringAttribute("type", &temp_str);
-		sim_config.ParseTracingPattern(std::string(temp_str));
+		config.ParseTracingPattern(std::string(temp_str));
 
 		// Get CSV filepath
 		root->FirstChildElement("csv_output")->QueryStringAttribute("prefix", &temp_str);
 
-		sim_config.csv_prefix = std::string(temp_str);
+		config.csv_prefix = std::string(temp_str);
+		if (tinyxml2::XMLElement *binary_output_element = root->FirstChildElement("binary_output"))
+		{
+			binary_output_element->QueryStringAttribute("path", &temp_str);
+			config.binary_output_path = std::string(temp_str);
+		}
+
+		// Get sampled metrics
+		if (tinyxml2::XMLElement *metrics_element = root->FirstChildElement("metrics"))
+		{
+			config.metrics_interval = metrics_element->UnsignedAttribute("interval");
+			for (tinyxml2::XMLElement *metric_element = metrics_element->FirstChildElement("metric"); metric_element; metric_element = metric_element->NextSiblingElement("metric"))
+			{
+				metric_element->QueryStringAttribute("name", &temp_str);
+				config.metrics.push_back(MetricSampler::fromName(std::string(temp_str)));
+			}
+		}
+
+		// Get checkpoint settings
+		if (tinyxml2::XMLElement *checkpoint_element = root->FirstChildElement("checkpoint"))
+		{
+			config.checkpoint_period = checkpoint_element->FirstChildElement("period")->UnsignedAttribute("int");
+			checkpoint_element->FirstChildElement("prefix")->QueryStringAttribute("path", &temp_str);
+			config.checkpoint_prefix = std::string(temp_str);
+			if (tinyxml2::XMLElement *resume_element = checkpoint_element->FirstChildElement("resume"))
+			{
+				config.checkpoint_resume = resume_element->BoolAttribute("bool");
+			}
+			if (tinyxml2::XMLElement *fork_element = checkpoint_element->FirstChildElement("fork"))
+			{
+				fork_element->QueryStringAttribute("path", &temp_str);
+				config.checkpoint_fork_path = std::string(temp_str);
+			}
+		}
+
+		// Get iteration summary settings
+		if (tinyxml2::XMLElement *summary_element = root->FirstChildElement("summary"))
+		{
+			config.summary_activation = summary_element->FirstChildElement("activate")->BoolAttribute("bool");
+			config.summary_keep_iterations = summary_element->FirstChildElement("keep_iterations")->BoolAttribute("bool");
+		}
 	}
 	catch (const std::exception &e)
 	{
 		std::cout << e.what() << std::endl;
 		exit(1);
 	}
+
+	return config;
 }
 
-void setStaticVariables()
+SimulationContext createSimulationContext(const SimulationConfiguration &config, const TrialSpec &trial)
 {
-	WorldCell::setHellPhermnEvprMulti(sim_config.malicious_evaporation_mult);
-	Ant::resetFoodBitsCounters();
-	Ant::setDilusionMax(*sim_config.patience_max_val_itr);
-	Ant::setDilusionIncrement((*sim_config.patience_max_val_itr) / (*sim_config.patience_refill_period_itr));
+	SimulationContext context;
+	context.hell_phermn_evpr_multi = config.malicious_evaporation_mult;
+	context.dilusion_max = config.patience_max;
+	context.dilusion_increment = config.patience_max / config.patience_refill_period;
+	// Only the trials of a trunk share their random streams, so the branches of a shared prefix go on from the same ants
+	context.seed = CounterRNG::getKey(config.sim_seed, trial.iteration, config.sweep.getTrunk(trial.point));
+	return context;
 }
 
-void initWorld(World &world, Colony &colony)
+void initWorld(const SimulationConfiguration &config, World &world, sf::Vector2f colony_position)
 {
-	setStaticVariables();
 	for (uint32_t i(0); i < 64; ++i)
 	{
 		float angle = float(i) / 64.0f * (2.0f * PI);
-		world.addMarker(colony.position + 16.0f * sf::Vector2f(cos(angle), sin(angle)), Mode::ToHome, 10.0f, true);
+		world.addMarker(colony_position + 16.0f * sf::Vector2f(cos(angle), sin(angle)), Mode::ToHome, 10.0f, true);
 	}
 
-	sf::Image food_map;
-	if (food_map.loadFromFile(sim_config.food_map_path))
+	FoodMap food_map;
+	if (food_map.loadFromFile(config.food_map_path))
 	{
-		for (uint32_t x(0); x < food_map.getSize().x; ++x)
+		for (uint32_t x(0); x < food_map.width; ++x)
 		{
-			for (uint32_t y(0); y < food_map.getSize().y; ++y)
+			for (uint32_t y(0); y < food_map.height; ++y)
 			{
 				const sf::Vector2f position = float(world.markers.cell_size) * sf::Vector2f(to<float>(x), to<float>(y));
 				if (food_map.getPixel(x, y).g > 100)
@@ -245,26 +515,58 @@ void initWorld(World &world, Colony &colony)
 	}
 }
 
-void updateColony(World &world, Colony &colony)
+// Simulated time of a step
+const float STEP_DT = 0.016f;
+
+/**
+ * @param field_stats If not null, receives the totals of the pheromone planes at the end of the step
+ */
+void updateColony(World &world, Colony &colony, SimulationContext &context, WorkerPool *ant_pool = nullptr, FieldStats *field_stats = nullptr)
+{
+	colony.update(STEP_DT, world, context, ant_pool);
+	world.update(STEP_DT, context, field_stats);
+}
+
+MetricSampler createMetricSampler(const SimulationConfiguration &config)
+{
+	const int datapoints_to_record = 100;
+	MetricSampler sampler;
+	sampler.interval = config.metrics_interval ? config.metrics_interval : std::max(1, config.sim_steps / datapoints_to_record);
+	if (config.metrics.empty())
+	{
+		sampler.addDefaultMetrics();
+	}
+	else
+	{
+		sampler.metrics = config.metrics;
+	}
+	return sampler;
+}
+
+void writeCsv(const std::string &filepath, const RunSeries &run)
+{
+	std::ofstream myfile(filepath);
+	const uint64_t row_count = run.getRowCount();
+	for (uint64_t row = 0; row < row_count; row++)
+	{
+		for (uint64_t column = 0; column < run.columns.size(); column++)
+		{
+			myfile << (column ? "," : "") << run.columns[column][row];
+		}
+		myfile << '\n';
+	}
+}
+
+std::string getSummaryCsvPath(const SimulationConfiguration &config)
 {
-	const static float dt = 0.016f;
-	colony.update(dt, world);
-	world.update(dt);
+	return config.csv_prefix + getConfigurationName(config) + "_summary.csv";
 }
 
-void oneExperiment(int i)
+void checkCsvPath(const std::string &filepath)
 {
-	std::ofstream myfile;
-	const static float dt = 0.016f;
-	const static int datapoints_to_record = 100;
-	static int skip_steps = sim_config.sim_steps / datapoints_to_record;
-	static std::string file_name_prefix = sim_config.csv_prefix;
-	static int x = 0;
-
-	std::string filepath = file_name_prefix + getExperimentSpecificName(i) + ".csv";
 	try
 	{
-		myfile.open(filepath);
+		std::ofstream myfile(filepath);
 		if (!myfile.is_open())
 		{
 			throw std::ios_base::failure("Cannot create path to " + filepath);
@@ -275,104 +577,438 @@ void oneExperiment(int i)
 		std::cerr << e.what() << '\n';
 		exit(1);
 	}
+}
 
-	float food_found_per_ant = 0.0;
-	float food_delivered_per_ant = 0.0;
-	float fraction_of_ants_found_food = 0.0;
-	float fraction_of_ants_delivered_food = 0.0;
+// World of every trial before the first step, built once since decoding the map is costly
+World createInitialWorld(const SimulationConfiguration &config)
+{
+	World world(Conf::WORLD_WIDTH, Conf::WORLD_HEIGHT, config.sim_lazy_decay, config.sim_grid_layout);
+	initWorld(config, world, Conf::COLONY_POSITION);
+	return world;
+}
 
-	setStaticVariables();
-	World world(Conf::WORLD_WIDTH, Conf::WORLD_HEIGHT);
-	Colony colony(Conf::COLONY_POSITION.x,
-				  Conf::COLONY_POSITION.y, Conf::ANTS_COUNT,
-				  sim_config.malicious_fraction,
-				  sim_config.malicious_timer_wait,
-				  sim_config.malicious_focus,
-				  sim_config.malicious_tracing_pattern,
-				  sim_config.patience_activation,
-				  sim_config.malicious_intensity_mult);
-	initWorld(world, colony);
-
-	for (int j = 0; j < sim_config.sim_steps; j++)
+RunSeries createRunSeries(const SimulationConfiguration &config, const TrialSpec &trial)
+{
+	const MetricSampler sampler = createMetricSampler(config);
+	RunSeries run;
+	addRunParameters(config, trial, run);
+	run.addParameter("record_period", sampler.interval);
+	sampler.addColumns(run);
+	return run;
+}
+
+/**
+ * @brief Everything a trial evolves, a shared prefix is copied to the trials that branch from it
+ */
+struct TrialState
+{
+	TrialState(const SimulationConfiguration &config, const TrialSpec &trial, const World &initial_world)
+		: context(createSimulationContext(config, trial))
+		, world(initial_world)
+		, colony(Conf::COLONY_POSITION.x,
+				 Conf::COLONY_POSITION.y, config.total_ant_number,
+				 context,
+				 config.malicious_fraction,
+				 config.malicious_timer_wait,
+				 config.malicious_focus,
+				 config.malicious_tracing_pattern,
+				 config.patience_activation,
+				 config.malicious_intensity_mult)
+		, run(createRunSeries(config, trial))
+		, next_step(0)
 	{
-		updateColony(world, colony);
-		if (j % skip_steps == 0)
+		colony.sort_period = config.sim_ant_sort_period;
+		colony.marker_intensities.exact = config.sim_exact_marker_intensity;
+	}
+
+	SimulationContext context;
+	World world;
+	Colony colony;
+	RunSeries run;
+	// First step that isn't simulated yet
+	int next_step;
+};
+
+/**
+ * @brief Give a copy of a shared prefix the parameters of a trial
+ *
+ * The trial must only differ from the one of the prefix by post attack parameters.
+ */
+void branchTrial(const SimulationConfiguration &config, const TrialSpec &trial, TrialState &state)
+{
+	SimulationContext context = createSimulationContext(config, trial);
+	context.addCounters(state.context);
+	state.context = context;
+	state.colony.mal_timer_delay = config.malicious_timer_wait;
+	state.colony.species.hell_phermn_intensity_multiplier = config.malicious_intensity_mult;
+	// They refer to the world of the prefix
+	state.colony.edit_buffers.clear();
+	// The prefix evaporated the fake food pheromone at the rate of its own trial
+	state.world.markers.replayDecayCarry(STEP_DT, state.context, static_cast<uint32_t>(state.next_step));
+	RunSeries run = createRunSeries(config, trial);
+	run.columns = state.run.columns;
+	state.run = run;
+}
+
+/**
+ * @brief Simulate the steps of a trial up to last_step (excluded)
+ *
+ * @param checkpoint_path Checkpoint file of the trial, empty to never save it
+ */
+void simulateSteps(const SimulationConfiguration &config, TrialState &state, int last_step, const std::string &checkpoint_path)
+{
+	const MetricSampler sampler = createMetricSampler(config);
+
+	// Step synchronous ant update, only when requested since it changes the outcome of the runs
+	std::unique_ptr<WorkerPool> ant_pool;
+	if (config.sim_ant_threads)
+	{
+		ant_pool.reset(new WorkerPool(config.sim_ant_threads));
+	}
+
+	// The grid totals are only computed on the steps that are sampled
+	const bool sample_field = sampler.needsFieldStats();
+	FieldStats field_stats;
+	for (int j = state.next_step; j < last_step; j++)
+	{
+		const bool sample_step = sampler.isSampleStep(j);
+		updateColony(state.world, state.colony, state.context, ant_pool.get(), (sample_step && sample_field) ? &field_stats : nullptr);
+		if (sample_step)
+		{
+			// Per ant metrics are normalized with the total number of ants
+			sampler.sample(state.context, field_stats, config.total_ant_number, state.run);
+		}
+		if (!checkpoint_path.empty() && ((j + 1) % config.checkpoint_period == 0 || j + 1 == config.sim_steps))
 		{
-			food_found_per_ant = float(Ant::getFoodBitsTaken()) / float(sim_config.total_ant_number);		  // Total  number of Ants
-			food_delivered_per_ant = float(Ant::getFoodBitsDelivered()) / float(sim_config.total_ant_number); // Total  number of Ants
-			fraction_of_ants_found_food = float(Colony::getAntsThatFoundFood()) / float(sim_config.total_ant_number);
-			fraction_of_ants_delivered_food = float(Colony::getAntsThatDeliveredFood()) / float(sim_config.total_ant_number);
-			myfile << (food_found_per_ant) << "," << food_delivered_per_ant << ","
-				   << fraction_of_ants_found_food << "," << fraction_of_ants_delivered_food << std::endl;
+			try
+			{
+				Checkpoint::save(checkpoint_path, state.world, state.colony, state.context, state.run, j + 1);
+			}
+			catch (const std::exception &e)
+			{
+				std::cerr << e.what() << '\n';
+				exit(1);
+			}
 		}
 	}
-	myfile.close();
-	std::cout << "Experiment " << x++ << " Done" << std::endl;
+	state.next_step = std::max(state.next_step, last_step);
 }
 
-void simulateAnts()
+/**
+ * @brief Run one trial and write its series unless only the summary of the iterations is kept
+ *
+ * @param initial_world World before the first step
+ * @param prefix Copy of the first steps of the trial, shared with other trials; nullptr to simulate them
+ * @return The recorded series of the trial
+ */
+RunSeries oneExperiment(const SimulationConfiguration &config, const TrialSpec &trial, ResultsFile::Writer *results, const World &initial_world, std::unique_ptr<TrialState> prefix = std::unique_ptr<TrialState>())
 {
-	/**
-	 * @brief This loop will start a new colony and run the sim for sim_config.sim_steps number of steps for each trial
-	 */
-	// Iterate through number of trials/iterations
-	for (int i = 0; i < sim_config.sim_iterations; i++)
-	{
-		/*
-			The following nested loops are constructed the way they are because of the original code's
-			dependency on global variables. Specifically, the `setStaticVariables()` function uses global
-			variables to set the simulation parameters that affect other parts of the code (see `oneExperiment()`).
+	const bool write_run = !config.summary_activation || config.summary_keep_iterations;
 
-			Ideally, the dependency on the global variable should be minimized and be explicit (i.e., traceable calls),
-			which can be achieved by using it in a single function and passed on to sub-function calls as arguments.
-		*/
+	std::string filepath = config.csv_prefix + getExperimentSpecificName(config, trial) + ".csv";
+	if (!results)
+	{
+		checkCsvPath(write_run ? filepath : getSummaryCsvPath(config));
+	}
 
-		// Iterate through all max patience pheromone values
-		for (auto &itr = sim_config.patience_max_val_itr; itr != sim_config.patience_max_val_vec.end(); ++itr)
+	std::unique_ptr<TrialState> state;
+	const std::string checkpoint_path = config.checkpoint_prefix + getExperimentSpecificName(config, trial) + ".ckpt";
+	if (prefix)
+	{
+		state = std::move(prefix);
+		branchTrial(config, trial, *state);
+	}
+	else
+	{
+		state.reset(new TrialState(config, trial, initial_world));
+		// Continue the trial from its own checkpoint, or from the warmed up run it forks
+		try
 		{
-			// Iterate through all patience refill period values
-			for (auto &itr = sim_config.patience_refill_period_itr; itr != sim_config.patience_refill_period_vec.end(); ++itr)
+			if (config.checkpoint_resume && std::ifstream(checkpoint_path).good())
+			{
+				state->next_step = static_cast<int>(Checkpoint::load(checkpoint_path, state->world, state->colony, state->context, state->run));
+			}
+			else if (!config.checkpoint_fork_path.empty())
 			{
-				oneExperiment(i); // run single experiment trial
+				const uint64_t trial_seed = state->context.seed;
+				state->next_step = static_cast<int>(Checkpoint::load(config.checkpoint_fork_path, state->world, state->colony, state->context, state->run));
+				// Forks of the same run differ by their own random streams and parameters from here on
+				state->context.seed = trial_seed;
+				state->colony.setMaliciousFraction(config.malicious_fraction);
 			}
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << e.what() << '\n';
+			exit(1);
+		}
+	}
+
+	simulateSteps(config, *state, config.sim_steps, config.checkpoint_period ? checkpoint_path : std::string());
+
+	if (write_run)
+	{
+		if (results)
+		{
+			results->write(state->run);
+		}
+		else
+		{
+			writeCsv(filepath, state->run);
+		}
+	}
+	return state->run;
+}
+
+/**
+ * @brief First steps of the trials of a trunk
+ *
+ * With the same iteration and the same parameters except the post attack ones, trials are identical until the
+ * malicious ants first attack. The steps before the earliest attack are simulated once and copied by each trial.
+ * The trials of a trunk are run one after the other and the prefix is freed once they have all copied it, so
+ * there are never many more prefixes than workers.
+ */
+struct SharedPrefix
+{
+	std::shared_future<std::shared_ptr<const TrialState>> state;
+	// Trials that still have to copy the prefix
+	uint64_t remaining;
+};
+
+// Number of steps the trials of a trunk share, 0 if they don't share any
+int getSharedPrefixSteps(const SimulationConfiguration &config)
+{
+	// Checkpointed trials restart from their own state
+	const bool checkpoints = config.checkpoint_period || config.checkpoint_resume || !config.checkpoint_fork_path.empty();
+	if (config.sweep.getBranchCount() < 2 || checkpoints)
+	{
+		return 0;
+	}
+	int first_attack = config.malicious_timer_wait;
+	if (const ParameterSweep<SimulationConfiguration>::Axis *delays = config.sweep.getAxis("mal_delay"))
+	{
+		first_attack = static_cast<int>(*std::min_element(delays->values.begin(), delays->values.end()));
+	}
+	return std::max(0, std::min(first_attack, config.sim_steps));
+}
 
-			sim_config.patience_refill_period_itr = sim_config.patience_refill_period_vec.begin();
+/**
+ * @brief Iterations of a configuration folded into its summary
+ *
+ * Runs are folded in iteration order whatever the order the trials end in, so the summary is reproducible.
+ */
+struct IterationSummary
+{
+	RunSummary summary;
+	// Finished runs waiting for the ones of previous iterations
+	std::map<int, RunSeries> pending;
+
+	// Returns true once all the iterations are folded
+	bool add(int iteration, RunSeries &&run, int iterations)
+	{
+		pending[iteration] = std::move(run);
+		std::map<int, RunSeries>::iterator next = pending.find(static_cast<int>(summary.run_count));
+		while (next != pending.end())
+		{
+			summary.add(next->second);
+			pending.erase(next);
+			next = pending.find(static_cast<int>(summary.run_count));
 		}
+		return summary.run_count == static_cast<uint64_t>(iterations);
+	}
+};
 
-		sim_config.patience_max_val_itr = sim_config.patience_max_val_vec.begin();
-		std::cout << "###########################" << std::endl;
-		std::cout << "Iteration " << i << " Done" << std::endl;
-		std::cout << "###########################" << std::endl;
+void simulateAnts(const SimulationConfiguration &config)
+{
+	/**
+	 * @brief Every (iteration, point of the sweep) combination is an independent trial with its own
+	 * World, Colony and counters, so the trials are dispatched to a pool of workers. Trials are numbered and
+	 * each worker takes the next number, the configuration of a trial is only built when it starts.
+	 */
+	const uint64_t point_count = config.sweep.getPointCount();
+	const uint64_t trial_count = point_count * config.sim_iterations;
+	// With the summary, the iterations of a point run one after the other so its summary is written early
+	const bool point_major = config.summary_activation;
+	// Trials sharing a prefix follow each other, trunk by trunk and iteration by iteration
+	const int prefix_steps = getSharedPrefixSteps(config);
+	const uint64_t branch_count = config.sweep.getBranchCount();
+	auto getTrial = [&config, point_count, point_major, prefix_steps, branch_count](uint64_t index) {
+		TrialSpec trial;
+		if (prefix_steps)
+		{
+			const uint64_t trunk_trials = branch_count * config.sim_iterations;
+			trial.iteration = static_cast<int>(index % trunk_trials / branch_count);
+			trial.point = static_cast<int>(config.sweep.getBranchPoint(index / trunk_trials, index % branch_count));
+			return trial;
+		}
+		trial.iteration = static_cast<int>(point_major ? index % config.sim_iterations : index / point_count);
+		trial.point = static_cast<int>(point_major ? index / config.sim_iterations : index % point_count);
+		return trial;
+	};
+
+	// Number of trials left before an iteration is reported as done
+	std::vector<uint64_t> remaining_trials(config.sim_iterations, point_count);
+	int experiments_done = 0;
+	std::mutex console_mutex;
+
+	// First steps of the trials, simulated once per (iteration, trunk)
+	std::map<uint64_t, SharedPrefix> prefixes;
+	std::mutex prefix_mutex;
+
+	// Statistics of the iterations of the points being simulated
+	std::map<int, IterationSummary> summaries;
+	std::mutex summary_mutex;
+
+	// All the trials append their run to the same results file
+	std::unique_ptr<ResultsFile::Writer> results;
+	if (!config.binary_output_path.empty())
+	{
+		try
+		{
+			results.reset(new ResultsFile::Writer(config.binary_output_path));
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << e.what() << '\n';
+			exit(1);
+		}
 	}
+
+	const World initial_world = createInitialWorld(config);
+	WorkerPool pool(config.sim_threads);
+	std::cout << "Running " << trial_count << " trials (" << point_count << " points) on " << pool.getThreadCount() << " threads" << std::endl;
+	std::atomic<uint64_t> next_trial(0);
+	for (uint32_t worker = 0; worker < pool.getThreadCount(); worker++)
+	{
+		pool.addJob([&]() {
+			for (uint64_t index = next_trial++; index < trial_count; index = next_trial++)
+			{
+				const TrialSpec trial = getTrial(index);
+				SimulationConfiguration point_config = config;
+				config.sweep.applyPoint(point_config, trial.point);
+
+				std::unique_ptr<TrialState> prefix;
+				const uint64_t prefix_key = config.sweep.getTrunk(trial.point) * config.sim_iterations + trial.iteration;
+				if (prefix_steps)
+				{
+					// The first trial of the trunk simulates the prefix, the others wait for it
+					std::unique_ptr<std::promise<std::shared_ptr<const TrialState>>> promise;
+					std::shared_future<std::shared_ptr<const TrialState>> future;
+					{
+						std::lock_guard<std::mutex> lock(prefix_mutex);
+						std::map<uint64_t, SharedPrefix>::iterator shared = prefixes.find(prefix_key);
+						if (shared == prefixes.end())
+						{
+							promise.reset(new std::promise<std::shared_ptr<const TrialState>>());
+							shared = prefixes.insert({prefix_key, SharedPrefix{promise->get_future().share(), branch_count}}).first;
+						}
+						future = shared->second.state;
+					}
+					if (promise)
+					{
+						std::shared_ptr<TrialState> state(new TrialState(point_config, trial, initial_world));
+						simulateSteps(point_config, *state, prefix_steps, std::string());
+						promise->set_value(state);
+					}
+					prefix.reset(new TrialState(*future.get()));
+					future = std::shared_future<std::shared_ptr<const TrialState>>();
+					std::lock_guard<std::mutex> lock(prefix_mutex);
+					if (--prefixes[prefix_key].remaining == 0)
+					{
+						prefixes.erase(prefix_key);
+					}
+				}
+
+				RunSeries run = oneExperiment(point_config, trial, results.get(), initial_world, std::move(prefix)); // run single experiment trial
+
+				if (config.summary_activation)
+				{
+					RunSeries summary;
+					{
+						std::lock_guard<std::mutex> lock(summary_mutex);
+						if (summaries[trial.point].add(trial.iteration, std::move(run), config.sim_iterations))
+						{
+							summary = summaries[trial.point].summary.getSeries("iter");
+							summaries.erase(trial.point);
+						}
+					}
+					if (!summary.columns.empty())
+					{
+						if (results)
+						{
+							results->write(summary);
+						}
+						else
+						{
+							writeCsv(getSummaryCsvPath(point_config), summary);
+						}
+					}
+				}
+
+				std::lock_guard<std::mutex> lock(console_mutex);
+				std::cout << "Experiment " << experiments_done++ << " Done" << std::endl;
+				if (--remaining_trials[trial.iteration] == 0)
+				{
+					std::cout << "###########################" << std::endl;
+					std::cout << "Iteration " << trial.iteration << " Done" << std::endl;
+					std::cout << "###########################" << std::endl;
+				}
+			}
+		});
+	}
+	pool.waitForCompletion();
 	std::cout << "########## DONE ##########" << std::endl;
 }
 
-void displaySimulation()
+#ifndef ANTSIM_HEADLESS
+void displaySimulation(const SimulationConfiguration &config)
 {
-	setStaticVariables();
-	World world(Conf::WORLD_WIDTH, Conf::WORLD_HEIGHT);
+	Conf::loadTextures();
+
+	// The first value of every swept parameter
+	const TrialSpec trial = {0, 0};
+	SimulationContext context = createSimulationContext(config, trial);
+	World world(Conf::WORLD_WIDTH, Conf::WORLD_HEIGHT, config.sim_lazy_decay, config.sim_grid_layout);
 	Colony colony(Conf::COLONY_POSITION.x,
 				  Conf::COLONY_POSITION.y,
-				  Conf::ANTS_COUNT,
-				  sim_config.malicious_fraction,
-				  sim_config.malicious_timer_wait,
-				  sim_config.malicious_focus,
-				  sim_config.malicious_tracing_pattern,
-				  sim_config.patience_activation,
-				  sim_config.malicious_intensity_mult);
+				  config.total_ant_number,
+				  context,
+				  config.malicious_fraction,
+				  config.malicious_timer_wait,
+				  config.malicious_focus,
+				  config.malicious_tracing_pattern,
+				  config.patience_activation,
+				  config.malicious_intensity_mult);
+	colony.marker_intensities.exact = config.sim_exact_marker_intensity;
 
 	sf::ContextSettings settings;
 	settings.antialiasingLevel = 4;
-	initWorld(world, colony);
-	auto sf_gui_display_style = sim_config.gui_fullscreen ? sf::Style::Fullscreen : sf::Style::Default;
+	initWorld(config, world, colony.position);
+	auto sf_gui_display_style = config.gui_fullscreen ? sf::Style::Fullscreen : sf::Style::Default;
 	sf::RenderWindow window(sf::VideoMode(Conf::WIN_WIDTH, Conf::WIN_HEIGHT), "AntSim", sf_gui_display_style, settings);
 	window.setFramerateLimit(60);
 
-	DisplayManager display_manager(window, window, world, colony);
+	// The steps run on their own thread, the loop below only shows the latest state and queues the edits.
+	// It stops before the world is destroyed and after the renderers that read it
+	SimulationThread simulation([&]() { updateColony(world, colony, context); }, config.gui_steps_per_frame);
+
+	// The renderers only exist while the simulation is displayed, their background threads read the grid with the
+	// state of the simulation locked
+	const FieldRenderer::StateLock lock_state = [&simulation]() { return simulation.lockStateBetweenSteps(); };
+	std::unique_ptr<FieldRenderer> world_renderer;
+	if (config.gui_field_texture)
+	{
+		world_renderer.reset(new FieldTextureRenderer(world.markers, lock_state, [&simulation]() { return simulation.getStateVersion(); }));
+	}
+	else
+	{
+		world_renderer.reset(new WorldRenderer(world.markers, lock_state));
+	}
+	ColonyRenderer colony_renderer(colony);
+	DisplayManager display_manager(window, window, world, colony, *world_renderer, colony_renderer);
 
 	sf::Vector2f last_clic;
-	int c = 0;
-	int C = -100;
+	uint64_t shown_step = 0;
 
 	while (window.isOpen())
 	{
@@ -387,50 +1023,54 @@ void displaySimulation()
 			{
 				if (display_manager.wall_mode)
 				{
-					world.addWall(world_position);
+					simulation.addCommand([&world, world_position]() { world.addWall(world_position); });
 				}
 				else if (display_manager.remove_wall)
 				{
-					world.removeWall(world_position);
+					simulation.addCommand([&world, world_position]() { world.removeWall(world_position); });
 				}
 				else
 				{
-					world.addFoodAt(world_position.x, world_position.y, 20);
+					simulation.addCommand([&world, world_position]() { world.addFoodAt(world_position.x, world_position.y, 20); });
 				}
 				last_clic = world_position;
 			}
 		}
 
-		if (!display_manager.pause)
-		{
-			updateColony(world, colony);
-			// std::cout<<std::endl;
-		}
+		simulation.requestFrame(display_manager.pause, display_manager.speed_mode);
 
-		if (c++ > C)
+		window.clear(sf::Color(94, 87, 87));
 		{
-			c = 0;
-			window.clear(sf::Color(94, 87, 87));
-
+			std::unique_lock<std::mutex> lock = simulation.lockState();
 			display_manager.draw();
-
-			window.display();
 		}
+		const uint64_t step = simulation.getStepCount();
+		if (step != shown_step)
+		{
+			window.setTitle("AntSim - step " + std::to_string(step));
+			shown_step = step;
+		}
+		window.display();
 	}
+	// Free textures
+	Conf::freeTextures();
 }
+#endif
 
 int main()
 {
-	Conf::loadTextures();
-
-	loadUserConf();
+	const SimulationConfiguration sim_config = loadUserConf();
 	if (sim_config.gui_display)
-		displaySimulation();
+	{
+#ifndef ANTSIM_HEADLESS
+		displaySimulation(sim_config);
+#else
+		std::cerr << "GUI is not available in a headless build, set gui/activate to false" << std::endl;
+		return 1;
+#endif
+	}
 	else
-		simulateAnts();
-
-	// Free textures
-	Conf::freeTextures();
+		simulateAnts(sim_config);
 
 	return 0;
 }
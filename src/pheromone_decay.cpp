@@ -0,0 +1,402 @@
+#include "pheromone_decay.hpp"
+#include <algorithm>
+
+// SSE2 is only part of the baseline instruction set on x86-64
+#if defined(__x86_64__) || defined(_M_X64)
+#define ANTSIM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ANTSIM_TARGET_AVX2
+#else
+#define ANTSIM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+namespace
+{
+	/////////////
+	// Scalar  //
+	void decayChannelScalar(float* intensity, const uint8_t* permanent, uint8_t mode_bit, float rate, uint64_t begin, uint64_t count)
+	{
+		for (uint64_t i(begin); i < count; ++i) {
+			const float decay = (permanent[i] & mode_bit) ? 0.0f : rate;
+			intensity[i] = std::max(0.0f, intensity[i] - decay);
+		}
+	}
+
+	void decayFoodChannelScalar(float* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, float rate, uint64_t begin, uint64_t count)
+	{
+		for (uint64_t i(begin); i < count; ++i) {
+			const bool is_permanent = permanent[i] & mode_bit;
+			const float decay = is_permanent ? 0.0f : rate;
+			const float value = std::max(0.0f, intensity[i] - decay);
+			const bool depleted = !food[i] && is_permanent;
+			intensity[i] = depleted ? 0.0f : value;
+			permanent[i] &= depleted ? ~mode_bit : 0xFF;
+		}
+	}
+
+	void decayChannelScalar16(uint16_t* intensity, const uint8_t* permanent, uint8_t mode_bit, uint16_t units, uint64_t begin, uint64_t count)
+	{
+		for (uint64_t i(begin); i < count; ++i) {
+			const uint16_t decay = (permanent[i] & mode_bit) ? 0 : units;
+			intensity[i] = intensity[i] > decay ? static_cast<uint16_t>(intensity[i] - decay) : 0;
+		}
+	}
+
+	void decayFoodChannelScalar16(uint16_t* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, uint16_t units, uint64_t begin, uint64_t count)
+	{
+		for (uint64_t i(begin); i < count; ++i) {
+			const bool is_permanent = permanent[i] & mode_bit;
+			const uint16_t decay = is_permanent ? 0 : units;
+			const uint16_t value = intensity[i] > decay ? static_cast<uint16_t>(intensity[i] - decay) : 0;
+			const bool depleted = !food[i] && is_permanent;
+			intensity[i] = depleted ? 0 : value;
+			permanent[i] &= depleted ? ~mode_bit : 0xFF;
+		}
+	}
+
+#ifdef ANTSIM_X86
+	/////////////
+	// SSE2    //
+	// All ones in the 32 bits lanes of the cells that are not permanent
+	inline __m128i expandLowBytes(__m128i byte_mask)
+	{
+		const __m128i words = _mm_unpacklo_epi8(byte_mask, byte_mask);
+		return _mm_unpacklo_epi16(words, words);
+	}
+
+	inline __m128 decay4(__m128 value, __m128i evaporates, __m128 rate)
+	{
+		const __m128 decay = _mm_and_ps(_mm_castsi128_ps(evaporates), rate);
+		// max(value, 0) returns 0 for NaN and -0, like std::max(0.0f, value)
+		return _mm_max_ps(_mm_sub_ps(value, decay), _mm_setzero_ps());
+	}
+
+	void decayChannelSSE2(float* intensity, const uint8_t* permanent, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 rate_4 = _mm_set1_ps(rate);
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			__m128i evaporates = _mm_cmpeq_epi8(_mm_and_si128(bits, bit), zero);
+			for (uint32_t k(0); k < 4; ++k) {
+				float* p = intensity + i + 4 * k;
+				_mm_storeu_ps(p, decay4(_mm_loadu_ps(p), expandLowBytes(evaporates), rate_4));
+				evaporates = _mm_srli_si128(evaporates, 4);
+			}
+		}
+		decayChannelScalar(intensity, permanent, mode_bit, rate, i, count);
+	}
+
+	void decayFoodChannelSSE2(float* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 rate_4 = _mm_set1_ps(rate);
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			const __m128i is_permanent = _mm_cmpeq_epi8(_mm_and_si128(bits, bit), bit);
+			// Cells without food, packed from 32 bits to 8 bits lanes
+			__m128i no_food[4];
+			for (uint32_t k(0); k < 4; ++k) {
+				no_food[k] = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(food + i + 4 * k)), zero);
+			}
+			const __m128i no_food_bytes = _mm_packs_epi16(_mm_packs_epi32(no_food[0], no_food[1]), _mm_packs_epi32(no_food[2], no_food[3]));
+			const __m128i depleted = _mm_and_si128(no_food_bytes, is_permanent);
+
+			__m128i evaporates = _mm_andnot_si128(is_permanent, _mm_set1_epi8(-1));
+			__m128i cleared = depleted;
+			for (uint32_t k(0); k < 4; ++k) {
+				float* p = intensity + i + 4 * k;
+				const __m128 value = decay4(_mm_loadu_ps(p), expandLowBytes(evaporates), rate_4);
+				_mm_storeu_ps(p, _mm_andnot_ps(_mm_castsi128_ps(expandLowBytes(cleared)), value));
+				evaporates = _mm_srli_si128(evaporates, 4);
+				cleared = _mm_srli_si128(cleared, 4);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(permanent + i), _mm_andnot_si128(_mm_and_si128(depleted, bit), bits));
+		}
+		decayFoodChannelScalar(intensity, permanent, food, mode_bit, rate, i, count);
+	}
+
+	// 16 bits planes, the byte masks are widened to the 16 bits lanes of the cells
+	void decayChannelSSE2_16(uint16_t* intensity, const uint8_t* permanent, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i units_8 = _mm_set1_epi16(static_cast<short>(units));
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			const __m128i evaporates = _mm_cmpeq_epi8(_mm_and_si128(bits, bit), zero);
+			__m128i* p = reinterpret_cast<__m128i*>(intensity + i);
+			const __m128i decay_lo = _mm_and_si128(_mm_unpacklo_epi8(evaporates, evaporates), units_8);
+			const __m128i decay_hi = _mm_and_si128(_mm_unpackhi_epi8(evaporates, evaporates), units_8);
+			_mm_storeu_si128(p, _mm_subs_epu16(_mm_loadu_si128(p), decay_lo));
+			_mm_storeu_si128(p + 1, _mm_subs_epu16(_mm_loadu_si128(p + 1), decay_hi));
+		}
+		decayChannelScalar16(intensity, permanent, mode_bit, units, i, count);
+	}
+
+	void decayFoodChannelSSE2_16(uint16_t* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i units_8 = _mm_set1_epi16(static_cast<short>(units));
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			const __m128i is_permanent = _mm_cmpeq_epi8(_mm_and_si128(bits, bit), bit);
+			__m128i no_food[4];
+			for (uint32_t k(0); k < 4; ++k) {
+				no_food[k] = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(food + i + 4 * k)), zero);
+			}
+			const __m128i no_food_bytes = _mm_packs_epi16(_mm_packs_epi32(no_food[0], no_food[1]), _mm_packs_epi32(no_food[2], no_food[3]));
+			const __m128i depleted = _mm_and_si128(no_food_bytes, is_permanent);
+			const __m128i evaporates = _mm_andnot_si128(is_permanent, _mm_set1_epi8(-1));
+
+			__m128i* p = reinterpret_cast<__m128i*>(intensity + i);
+			const __m128i decay_lo = _mm_and_si128(_mm_unpacklo_epi8(evaporates, evaporates), units_8);
+			const __m128i decay_hi = _mm_and_si128(_mm_unpackhi_epi8(evaporates, evaporates), units_8);
+			const __m128i value_lo = _mm_subs_epu16(_mm_loadu_si128(p), decay_lo);
+			const __m128i value_hi = _mm_subs_epu16(_mm_loadu_si128(p + 1), decay_hi);
+			_mm_storeu_si128(p, _mm_andnot_si128(_mm_unpacklo_epi8(depleted, depleted), value_lo));
+			_mm_storeu_si128(p + 1, _mm_andnot_si128(_mm_unpackhi_epi8(depleted, depleted), value_hi));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(permanent + i), _mm_andnot_si128(_mm_and_si128(depleted, bit), bits));
+		}
+		decayFoodChannelScalar16(intensity, permanent, food, mode_bit, units, i, count);
+	}
+
+	/////////////
+	// AVX2    //
+	ANTSIM_TARGET_AVX2
+	void decayChannelAVX2(float* intensity, const uint8_t* permanent, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m128i zero = _mm_setzero_si128();
+		const __m256 rate_8 = _mm256_set1_ps(rate);
+		const __m256 zero_8 = _mm256_setzero_ps();
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			const __m128i evaporates = _mm_cmpeq_epi8(_mm_and_si128(bits, bit), zero);
+			const __m256 mask_lo = _mm256_castsi256_ps(_mm256_cvtepi8_epi32(evaporates));
+			const __m256 mask_hi = _mm256_castsi256_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(evaporates, 8)));
+			const __m256 value_lo = _mm256_sub_ps(_mm256_loadu_ps(intensity + i), _mm256_and_ps(mask_lo, rate_8));
+			const __m256 value_hi = _mm256_sub_ps(_mm256_loadu_ps(intensity + i + 8), _mm256_and_ps(mask_hi, rate_8));
+			_mm256_storeu_ps(intensity + i, _mm256_max_ps(value_lo, zero_8));
+			_mm256_storeu_ps(intensity + i + 8, _mm256_max_ps(value_hi, zero_8));
+		}
+		decayChannelScalar(intensity, permanent, mode_bit, rate, i, count);
+	}
+
+	ANTSIM_TARGET_AVX2
+	void decayFoodChannelAVX2(float* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m256i zero_i = _mm256_setzero_si256();
+		const __m256 rate_8 = _mm256_set1_ps(rate);
+		const __m256 zero_8 = _mm256_setzero_ps();
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			const __m128i is_permanent = _mm_cmpeq_epi8(_mm_and_si128(bits, bit), bit);
+			const __m256i permanent_lo = _mm256_cvtepi8_epi32(is_permanent);
+			const __m256i permanent_hi = _mm256_cvtepi8_epi32(_mm_srli_si128(is_permanent, 8));
+			const __m256i no_food_lo = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(food + i)), zero_i);
+			const __m256i no_food_hi = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(food + i + 8)), zero_i);
+			const __m256 depleted_lo = _mm256_castsi256_ps(_mm256_and_si256(no_food_lo, permanent_lo));
+			const __m256 depleted_hi = _mm256_castsi256_ps(_mm256_and_si256(no_food_hi, permanent_hi));
+
+			__m256 value_lo = _mm256_sub_ps(_mm256_loadu_ps(intensity + i), _mm256_andnot_ps(_mm256_castsi256_ps(permanent_lo), rate_8));
+			__m256 value_hi = _mm256_sub_ps(_mm256_loadu_ps(intensity + i + 8), _mm256_andnot_ps(_mm256_castsi256_ps(permanent_hi), rate_8));
+			value_lo = _mm256_andnot_ps(depleted_lo, _mm256_max_ps(value_lo, zero_8));
+			value_hi = _mm256_andnot_ps(depleted_hi, _mm256_max_ps(value_hi, zero_8));
+			_mm256_storeu_ps(intensity + i, value_lo);
+			_mm256_storeu_ps(intensity + i + 8, value_hi);
+
+			// Pack the 32 bits depletion masks back to one byte per cell
+			const __m256i depleted_16 = _mm256_packs_epi32(_mm256_castps_si256(depleted_lo), _mm256_castps_si256(depleted_hi));
+			const __m128i depleted_bytes = _mm_packs_epi16(_mm256_castsi256_si128(depleted_16), _mm256_extracti128_si256(depleted_16, 1));
+			// packs works within 128 bits lanes: reorder [lo0 hi0 lo1 hi1] into [lo0 lo1 hi0 hi1]
+			const __m128i depleted_ordered = _mm_shuffle_epi32(depleted_bytes, _MM_SHUFFLE(3, 1, 2, 0));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(permanent + i), _mm_andnot_si128(_mm_and_si128(depleted_ordered, bit), bits));
+		}
+		decayFoodChannelScalar(intensity, permanent, food, mode_bit, rate, i, count);
+	}
+
+	ANTSIM_TARGET_AVX2
+	void decayChannelAVX2_16(uint16_t* intensity, const uint8_t* permanent, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m128i zero = _mm_setzero_si128();
+		const __m256i units_16 = _mm256_set1_epi16(static_cast<short>(units));
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			const __m256i evaporates = _mm256_cvtepi8_epi16(_mm_cmpeq_epi8(_mm_and_si128(bits, bit), zero));
+			__m256i* p = reinterpret_cast<__m256i*>(intensity + i);
+			_mm256_storeu_si256(p, _mm256_subs_epu16(_mm256_loadu_si256(p), _mm256_and_si256(evaporates, units_16)));
+		}
+		decayChannelScalar16(intensity, permanent, mode_bit, units, i, count);
+	}
+
+	ANTSIM_TARGET_AVX2
+	void decayFoodChannelAVX2_16(uint16_t* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		const __m128i bit = _mm_set1_epi8(static_cast<char>(mode_bit));
+		const __m256i zero_i = _mm256_setzero_si256();
+		const __m256i units_16 = _mm256_set1_epi16(static_cast<short>(units));
+		uint64_t i(0);
+		for (; i + 16 <= count; i += 16) {
+			const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(permanent + i));
+			const __m128i is_permanent = _mm_cmpeq_epi8(_mm_and_si128(bits, bit), bit);
+			const __m256i no_food_lo = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(food + i)), zero_i);
+			const __m256i no_food_hi = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(food + i + 8)), zero_i);
+			// packs works within 128 bits lanes: reorder [lo0 hi0 lo1 hi1] into [lo0 lo1 hi0 hi1]
+			const __m256i no_food = _mm256_permute4x64_epi64(_mm256_packs_epi32(no_food_lo, no_food_hi), _MM_SHUFFLE(3, 1, 2, 0));
+			const __m256i permanent_16 = _mm256_cvtepi8_epi16(is_permanent);
+			const __m256i depleted = _mm256_and_si256(no_food, permanent_16);
+
+			__m256i* p = reinterpret_cast<__m256i*>(intensity + i);
+			const __m256i value = _mm256_subs_epu16(_mm256_loadu_si256(p), _mm256_andnot_si256(permanent_16, units_16));
+			_mm256_storeu_si256(p, _mm256_andnot_si256(depleted, value));
+
+			const __m128i depleted_bytes = _mm_packs_epi16(_mm256_castsi256_si128(depleted), _mm256_extracti128_si256(depleted, 1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(permanent + i), _mm_andnot_si128(_mm_and_si128(depleted_bytes, bit), bits));
+		}
+		decayFoodChannelScalar16(intensity, permanent, food, mode_bit, units, i, count);
+	}
+
+	bool hasAVX2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuid(info, 1);
+		const bool os_saves_ymm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 0x6) == 0x6);
+		__cpuidex(info, 7, 0);
+		return os_saves_ymm && (info[1] & (1 << 5));
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	struct Implementation
+	{
+		const char* name;
+		void (*decay_channel)(float*, const uint8_t*, uint8_t, float, uint64_t);
+		void (*decay_food_channel)(float*, uint8_t*, const uint32_t*, uint8_t, float, uint64_t);
+		void (*decay_channel_16)(uint16_t*, const uint8_t*, uint8_t, uint16_t, uint64_t);
+		void (*decay_food_channel_16)(uint16_t*, uint8_t*, const uint32_t*, uint8_t, uint16_t, uint64_t);
+	};
+
+	void decayChannelScalarAll(float* intensity, const uint8_t* permanent, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		decayChannelScalar(intensity, permanent, mode_bit, rate, 0, count);
+	}
+
+	void decayFoodChannelScalarAll(float* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		decayFoodChannelScalar(intensity, permanent, food, mode_bit, rate, 0, count);
+	}
+
+	void decayChannelScalar16All(uint16_t* intensity, const uint8_t* permanent, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		decayChannelScalar16(intensity, permanent, mode_bit, units, 0, count);
+	}
+
+	void decayFoodChannelScalar16All(uint16_t* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		decayFoodChannelScalar16(intensity, permanent, food, mode_bit, units, 0, count);
+	}
+
+	Implementation getScalarImplementation()
+	{
+		return { "scalar", decayChannelScalarAll, decayFoodChannelScalarAll, decayChannelScalar16All, decayFoodChannelScalar16All };
+	}
+
+#ifdef ANTSIM_X86
+	Implementation getSSE2Implementation()
+	{
+		return { "SSE2", decayChannelSSE2, decayFoodChannelSSE2, decayChannelSSE2_16, decayFoodChannelSSE2_16 };
+	}
+
+	Implementation getAVX2Implementation()
+	{
+		return { "AVX2", decayChannelAVX2, decayFoodChannelAVX2, decayChannelAVX2_16, decayFoodChannelAVX2_16 };
+	}
+#endif
+
+	Implementation selectImplementation()
+	{
+#ifdef ANTSIM_X86
+		return hasAVX2() ? getAVX2Implementation() : getSSE2Implementation();
+#else
+		return getScalarImplementation();
+#endif
+	}
+
+	Implementation& getImplementation()
+	{
+		static Implementation implementation = selectImplementation();
+		return implementation;
+	}
+}
+
+
+namespace PheromoneDecay
+{
+	void decayChannel(float* intensity, const uint8_t* permanent, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		getImplementation().decay_channel(intensity, permanent, mode_bit, rate, count);
+	}
+
+	void decayFoodChannel(float* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, float rate, uint64_t count)
+	{
+		getImplementation().decay_food_channel(intensity, permanent, food, mode_bit, rate, count);
+	}
+
+	void decayChannel(uint16_t* intensity, const uint8_t* permanent, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		getImplementation().decay_channel_16(intensity, permanent, mode_bit, units, count);
+	}
+
+	void decayFoodChannel(uint16_t* intensity, uint8_t* permanent, const uint32_t* food, uint8_t mode_bit, uint16_t units, uint64_t count)
+	{
+		getImplementation().decay_food_channel_16(intensity, permanent, food, mode_bit, units, count);
+	}
+
+	const char* getImplementationName()
+	{
+		return getImplementation().name;
+	}
+
+	bool setImplementation(const std::string& name)
+	{
+		if (name == "scalar") {
+			getImplementation() = getScalarImplementation();
+			return true;
+		}
+#ifdef ANTSIM_X86
+		if (name == "SSE2") {
+			getImplementation() = getSSE2Implementation();
+			return true;
+		}
+		if (name == "AVX2" && hasAVX2()) {
+			getImplementation() = getAVX2Implementation();
+			return true;
+		}
+#endif
+		return false;
+	}
+}
@@ -1,19 +1,14 @@
 #include "utils.hpp"
-#include <random>
-
-std::random_device rd();
-std::mt19937 gen(0);
+#include "number_generator.hpp"
 
 float getRandRange(float width)
 {
-	std::uniform_real_distribution<float> distr(-width, width);
-	return distr(gen);
+	return RNGf::getRange(-width, width);
 }
 
 float getRandUnder(float width)
 {
-	std::uniform_real_distribution<float> distr(0.0f, width);
-	return distr(gen);
+	return RNGf::getUnder(width);
 }
 
 
@@ -0,0 +1,128 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "colony.hpp"
+#include "config.hpp"
+#include "metrics.hpp"
+#include "number_generator.hpp"
+#include "results_file.hpp"
+#include "simulation_context.hpp"
+#include "world.hpp"
+
+
+/**
+ * Two runs with their own SimulationContext simulated on two threads record the same series as the same runs
+ * simulated one after the other: nothing of a run leaks into the other through shared state.
+ */
+
+struct TrialParameters
+{
+	uint64_t seed;
+	float malicious_fraction;
+	int malicious_timer_wait;
+	bool counter_pheromone;
+	float hell_phermn_evpr_multi;
+};
+
+const uint32_t ANTS_COUNT = 256;
+const uint32_t STEPS = 600;
+
+RunSeries simulate(const TrialParameters& parameters)
+{
+	SimulationContext context;
+	context.hell_phermn_evpr_multi = parameters.hell_phermn_evpr_multi;
+	context.dilusion_max = 40.0f;
+	context.dilusion_increment = 1.0f;
+	context.seed = CounterRNG::getKey(parameters.seed, 0, 0);
+
+	World world(Conf::WORLD_WIDTH, Conf::WORLD_HEIGHT);
+	for (uint32_t i(0); i < 64; ++i) {
+		const float angle = float(i) / 64.0f * (2.0f * PI);
+		world.addMarker(Conf::COLONY_POSITION + 16.0f * sf::Vector2f(cos(angle), sin(angle)), Mode::ToHome, 10.0f, true);
+	}
+	// A patch of food close enough to the colony to be found within the run
+	for (float x(1100.0f); x < 1160.0f; x += 4.0f) {
+		for (float y(420.0f); y < 480.0f; y += 4.0f) {
+			world.addFoodAt(x, y, 5);
+		}
+	}
+
+	Colony colony(Conf::COLONY_POSITION.x, Conf::COLONY_POSITION.y, ANTS_COUNT, context, parameters.malicious_fraction,
+				  parameters.malicious_timer_wait, true, AntTracingPattern::FOOD, parameters.counter_pheromone, 2.0f);
+
+	MetricSampler sampler;
+	sampler.interval = 10;
+	for (uint32_t i(0); i < to<uint32_t>(Metric::Count); ++i) {
+		sampler.metrics.push_back(static_cast<Metric>(i));
+	}
+	RunSeries run;
+	sampler.addColumns(run);
+
+	const float dt = 0.016f;
+	FieldStats field_stats;
+	for (uint32_t step(0); step < STEPS; ++step) {
+		const bool sample_step = sampler.isSampleStep(step);
+		colony.update(dt, world, context);
+		world.update(dt, context, sample_step ? &field_stats : nullptr);
+		if (sample_step) {
+			sampler.sample(context, field_stats, ANTS_COUNT, run);
+		}
+	}
+	return run;
+}
+
+// Number of values that differ, the runs must have the same columns
+uint64_t countDifferences(const RunSeries& expected, const RunSeries& actual, const std::string& name)
+{
+	uint64_t differences = 0;
+	for (uint64_t column(0); column < expected.columns.size(); ++column) {
+		for (uint64_t row(0); row < expected.getRowCount(); ++row) {
+			if (expected.columns[column][row] != actual.columns[column][row]) {
+				if (!differences) {
+					std::cerr << name << ": " << expected.column_names[column] << " differs at row " << row << ", "
+							  << expected.columns[column][row] << " instead of " << actual.columns[column][row] << std::endl;
+				}
+				++differences;
+			}
+		}
+	}
+	return differences;
+}
+
+int main()
+{
+	const TrialParameters first = { 1, 0.1f, 200, false, 1.0f };
+	const TrialParameters second = { 2, 0.3f, 100, true, 0.5f };
+
+	const RunSeries first_sequential = simulate(first);
+	const RunSeries second_sequential = simulate(second);
+
+	RunSeries first_concurrent;
+	RunSeries second_concurrent;
+	std::thread first_thread([&]() { first_concurrent = simulate(first); });
+	std::thread second_thread([&]() { second_concurrent = simulate(second); });
+	first_thread.join();
+	second_thread.join();
+
+	// Runs that never find food or never attack would compare equal without testing much
+	const uint64_t last_row = first_sequential.getRowCount() - 1;
+	if (first_sequential.columns[to<uint32_t>(Metric::FoodFoundPerAnt)][last_row] <= 0.0f ||
+		second_sequential.columns[to<uint32_t>(Metric::MassToHell)][last_row] <= 0.0f) {
+		std::cerr << "The runs don't exercise the food and the malicious trails" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (first_sequential.columns == second_sequential.columns) {
+		std::cerr << "The two configurations record the same series" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const uint64_t differences = countDifferences(first_sequential, first_concurrent, "first run") +
+								 countDifferences(second_sequential, second_concurrent, "second run");
+	if (differences) {
+		std::cerr << differences << " values differ between the sequential and the concurrent runs" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Concurrent runs match the sequential runs over " << first_sequential.getRowCount() << " samples" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "number_generator.hpp"
+#include "pheromone_decay.hpp"
+#include "utils.hpp"
+
+
+/**
+ * Every evaporation kernel the CPU supports gives the same bits as the scalar one, on planes of any length and
+ * alignment so that the vector loops and their scalar tails are both covered.
+ */
+
+struct Planes
+{
+	std::vector<float> intensity;
+	std::vector<float> food_intensity;
+	std::vector<uint16_t> units;
+	std::vector<uint16_t> food_units;
+	std::vector<uint8_t> permanent;
+	std::vector<uint8_t> permanent_16;
+	std::vector<uint32_t> food;
+
+	// Bitwise, -0 differs from 0
+	bool operator==(const Planes& other) const
+	{
+		return isSame(intensity, other.intensity) && isSame(food_intensity, other.food_intensity) && isSame(units, other.units) &&
+			   isSame(food_units, other.food_units) && isSame(permanent, other.permanent) && isSame(permanent_16, other.permanent_16);
+	}
+
+	template<typename T>
+	static bool isSame(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && !std::memcmp(a.data(), b.data(), a.size() * sizeof(T));
+	}
+};
+
+const uint8_t MODE_BIT = 1 << 1;
+const uint8_t FOOD_MODE_BIT = 1 << 2;
+const float RATE = 0.75f;
+const uint16_t UNITS = 48;
+
+// Intensities above, below and at the rate, signed zeros and denormals, permanent cells with and without food
+Planes createPlanes(uint64_t count)
+{
+	CounterRNG::setStream(1, count, 0);
+	Planes planes;
+	for (uint64_t i(0); i < count; ++i) {
+		const uint64_t bits = CounterRNG::next();
+		const float values[] = { 0.0f, -0.0f, 1e-40f, RATE, 0.5f * RATE, RATE + 1e-6f, 1000.0f * CounterRNG::nextFloat(), CounterRNG::nextFloat() };
+		planes.intensity.push_back(values[bits & 7]);
+		planes.food_intensity.push_back(values[(bits >> 3) & 7]);
+		const uint16_t units[] = { 0, UNITS, UNITS / 2, to<uint16_t>(bits >> 48) };
+		planes.units.push_back(units[(bits >> 6) & 3]);
+		planes.food_units.push_back(units[(bits >> 8) & 3]);
+		planes.permanent.push_back(to<uint8_t>(bits >> 10));
+		planes.food.push_back((bits >> 18) & 1 ? to<uint32_t>((bits >> 19) & 7) : 0);
+	}
+	planes.permanent_16 = planes.permanent;
+	return planes;
+}
+
+// Decay the cells from offset on with the current implementation
+Planes decay(Planes planes, uint64_t offset)
+{
+	const uint64_t count = planes.intensity.size() - offset;
+	PheromoneDecay::decayChannel(&planes.intensity[offset], &planes.permanent[offset], MODE_BIT, RATE, count);
+	PheromoneDecay::decayFoodChannel(&planes.food_intensity[offset], &planes.permanent[offset], &planes.food[offset], FOOD_MODE_BIT, RATE, count);
+	PheromoneDecay::decayChannel(&planes.units[offset], &planes.permanent_16[offset], MODE_BIT, UNITS, count);
+	PheromoneDecay::decayFoodChannel(&planes.food_units[offset], &planes.permanent_16[offset], &planes.food[offset], FOOD_MODE_BIT, UNITS, count);
+	return planes;
+}
+
+int main()
+{
+	const char* names[] = { "SSE2", "AVX2" };
+	uint32_t compared = 0;
+	uint32_t failures = 0;
+	for (const char* name : names) {
+		if (!PheromoneDecay::setImplementation(name)) {
+			std::cout << name << " isn't supported, skipped" << std::endl;
+			continue;
+		}
+		++compared;
+		for (uint64_t count(1); count < 300; count += 7) {
+			const Planes planes = createPlanes(count + 3);
+			for (uint64_t offset(0); offset < 4; ++offset) {
+				PheromoneDecay::setImplementation("scalar");
+				const Planes expected = decay(planes, offset);
+				PheromoneDecay::setImplementation(name);
+				if (!(decay(planes, offset) == expected)) {
+					std::cerr << name << " differs from scalar on " << count << " cells at offset " << offset << std::endl;
+					++failures;
+				}
+			}
+		}
+	}
+	if (PheromoneDecay::setImplementation("NEON")) {
+		std::cerr << "An unknown implementation was accepted" << std::endl;
+		++failures;
+	}
+	if (failures) {
+		return EXIT_FAILURE;
+	}
+	std::cout << compared << " implementations match the scalar one" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include "direction.hpp"
+#include "utils.hpp"
+
+
+/**
+ * The polynomial rotations of Direction stay within the bounds of its documentation: one rotation is off by at
+ * most 1e-7 rad below 0.5 rad and 6e-7 rad up to PI, and over 1000 updates turning the target every time, the
+ * heading and the target stay within 4e-6 rad of the same steering computed with angles in double precision while
+ * the vectors stay within 2e-7 of unit length.
+ */
+
+const double ROTATE_TOLERANCE = 1e-7;
+const double HALVED_ROTATE_TOLERANCE = 6e-7;
+const double HEADING_TOLERANCE = 4e-6;
+const double NORM_TOLERANCE = 2e-7;
+const uint32_t UPDATES = 1000;
+// PI of utils.hpp is a float
+const double PI_64 = 3.14159265358979323846;
+
+// Difference of two angles, in [0, pi]
+double getAngleError(sf::Vector2f v, double expected)
+{
+	const double d = std::fmod(std::abs(std::atan2(double(v.y), double(v.x)) - expected), 2.0 * PI_64);
+	return std::min(d, 2.0 * PI_64 - d);
+}
+
+double getNormDrift(sf::Vector2f v)
+{
+	return std::abs(std::sqrt(double(v.x) * double(v.x) + double(v.y) * double(v.y)) - 1.0);
+}
+
+int main()
+{
+	uint32_t failures = 0;
+
+	// One rotation of unit vectors of every heading, by angles up to PI
+	double rotate_error = 0.0;
+	double halved_rotate_error = 0.0;
+	double rotate_drift = 0.0;
+	for (int32_t h(-180); h < 180; ++h) {
+		const double heading = double(h) / 180.0 * PI_64;
+		const sf::Vector2f v(to<float>(std::cos(heading)), to<float>(std::sin(heading)));
+		// The vector itself is rounded to float
+		const double start = std::atan2(double(v.y), double(v.x));
+		for (int32_t a(-3141); a <= 3141; ++a) {
+			const float angle = to<float>(a) * 1e-3f;
+			const sf::Vector2f r = Direction::rotate(v, angle);
+			double& error = std::abs(angle) > 0.5f ? halved_rotate_error : rotate_error;
+			error = std::max(error, getAngleError(r, start + double(angle)));
+			rotate_drift = std::max(rotate_drift, getNormDrift(r));
+		}
+	}
+	if (rotate_error > ROTATE_TOLERANCE || halved_rotate_error > HALVED_ROTATE_TOLERANCE || rotate_drift > NORM_TOLERANCE) {
+		std::cerr << "rotate is off by " << rotate_error << " rad below 0.5 rad, " << halved_rotate_error << " rad above, with a norm drift of "
+				  << rotate_drift << std::endl;
+		++failures;
+	}
+
+	// Headings of every angle steered toward targets offset by up to 2.5 rad and turning at various rates, against
+	// the same steering in double. Closer to a half turn, any rounding decides the side the heading turns to.
+	double heading_error = 0.0;
+	double heading_drift = 0.0;
+	const float dt = 0.016f;
+	for (int32_t h(0); h < 32; ++h) {
+		for (int32_t o(-25); o <= 25; ++o) {
+			for (int32_t t(-5); t <= 5; ++t) {
+				const float turn = to<float>(t) * 0.01f;
+				Direction direction(to<float>(double(h) / 32.0 * 2.0 * PI_64));
+				direction += to<float>(o) * 0.1f;
+				double heading = std::atan2(double(direction.getVec().y), double(direction.getVec().x));
+				double target = std::atan2(double(direction.getTargetVec().y), double(direction.getTargetVec().x));
+				double rotation = 0.0;
+				for (uint32_t i(0); i < UPDATES; ++i) {
+					direction += turn;
+					target += double(turn);
+					direction.update(dt);
+					heading += rotation;
+					rotation = 10.0 * std::sin(target - heading) * double(dt);
+					heading_error = std::max(heading_error, std::max(getAngleError(direction.getVec(), heading), getAngleError(direction.getTargetVec(), target)));
+					heading_drift = std::max(heading_drift, std::max(getNormDrift(direction.getVec()), getNormDrift(direction.getTargetVec())));
+				}
+			}
+		}
+	}
+	if (heading_error > HEADING_TOLERANCE || heading_drift > NORM_TOLERANCE) {
+		std::cerr << "Over " << UPDATES << " updates the heading is off by " << heading_error << " rad with a norm drift of " << heading_drift << std::endl;
+		++failures;
+	}
+
+	if (failures) {
+		return EXIT_FAILURE;
+	}
+	std::cout << "rotate off by " << rotate_error << " rad (" << halved_rotate_error << " rad above 0.5 rad), heading off by " << heading_error
+			  << " rad over " << UPDATES << " updates, norm drift " << std::max(rotate_drift, heading_drift) << std::endl;
+	return EXIT_SUCCESS;
+}
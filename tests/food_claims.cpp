@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "colony.hpp"
+#include "config.hpp"
+#include "number_generator.hpp"
+#include "simulation_context.hpp"
+#include "worker_pool.hpp"
+#include "world.hpp"
+
+
+/**
+ * With the step synchronous update, ants that reach a cell holding its last food bits in the same step only take
+ * what the cell holds: the food the ants count as taken is the food that leaves the grid. The outcome still
+ * doesn't depend on the number of threads nor on the sort of the ants.
+ */
+
+struct Outcome
+{
+	int food_bits_taken;
+	uint64_t food_removed;
+	std::vector<sf::Vector2f> positions;
+};
+
+const uint32_t ANTS_COUNT = 2048;
+const uint32_t STEPS = 1500;
+
+uint64_t getFood(const World& world)
+{
+	uint64_t food = 0;
+	for (uint32_t quantity : world.markers.food) {
+		food += quantity;
+	}
+	return food;
+}
+
+Outcome simulate(uint32_t ant_threads, uint32_t sort_period)
+{
+	SimulationContext context;
+	context.dilusion_max = 40.0f;
+	context.dilusion_increment = 1.0f;
+	context.seed = CounterRNG::getKey(1, 0, 0);
+
+	World world(Conf::WORLD_WIDTH, Conf::WORLD_HEIGHT);
+	for (uint32_t i(0); i < 64; ++i) {
+		const float angle = float(i) / 64.0f * (2.0f * PI);
+		world.addMarker(Conf::COLONY_POSITION + 16.0f * sf::Vector2f(cos(angle), sin(angle)), Mode::ToHome, 10.0f, true);
+	}
+	// Single bit cells close to the colony, many ants reach them in the same steps
+	for (float x(1040.0f); x < 1100.0f; x += 4.0f) {
+		for (float y(500.0f); y < 560.0f; y += 4.0f) {
+			world.addFoodAt(x, y, 1);
+		}
+	}
+	const uint64_t initial_food = getFood(world);
+
+	Colony colony(Conf::COLONY_POSITION.x, Conf::COLONY_POSITION.y, ANTS_COUNT, context, 0.0f, 0);
+	colony.sort_period = sort_period;
+	WorkerPool pool(ant_threads);
+	const float dt = 0.016f;
+	for (uint32_t step(0); step < STEPS; ++step) {
+		colony.update(dt, world, context, &pool);
+		world.update(dt, context);
+	}
+
+	colony.ants.sortById();
+	return {context.food_bits_taken, initial_food - getFood(world), colony.ants.position};
+}
+
+int main()
+{
+	const uint32_t configurations[][2] = { { 1, 0 }, { 4, 0 }, { 4, 10 } };
+	std::vector<Outcome> outcomes;
+	uint32_t failures = 0;
+	for (const uint32_t* configuration : configurations) {
+		outcomes.push_back(simulate(configuration[0], configuration[1]));
+		const Outcome& outcome = outcomes.back();
+		if (to<uint64_t>(outcome.food_bits_taken) != outcome.food_removed) {
+			std::cerr << configuration[0] << " threads, sort period " << configuration[1] << ": " << outcome.food_bits_taken
+					  << " food bits taken but " << outcome.food_removed << " removed from the grid" << std::endl;
+			++failures;
+		}
+		if (outcome.positions != outcomes.front().positions) {
+			std::cerr << configuration[0] << " threads, sort period " << configuration[1] << ": the ants end elsewhere than with 1 thread" << std::endl;
+			++failures;
+		}
+	}
+	if (!outcomes.front().food_removed) {
+		std::cerr << "The ants never found the food" << std::endl;
+		++failures;
+	}
+	if (failures) {
+		return EXIT_FAILURE;
+	}
+	std::cout << outcomes.front().food_bits_taken << " food bits taken and removed from the grid" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+#include <iostream>
+#include "results_file.hpp"
+
+/*
+ * Print the content of a results file written with <binary_output path="..."/>
+ * Each run is printed as its parameters followed by its series in CSV
+ */
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <results file>" << std::endl;
+		return 1;
+	}
+
+	std::vector<RunSeries> runs;
+	try
+	{
+		runs = ResultsFile::read(argv[1]);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	for (uint64_t i = 0; i < runs.size(); i++)
+	{
+		const RunSeries &run = runs[i];
+		std::cout << "# run " << i;
+		for (const RunSeries::Parameter &parameter : run.parameters)
+		{
+			std::cout << " " << parameter.name << "=" << parameter.value;
+		}
+		std::cout << '\n';
+		for (uint64_t column = 0; column < run.column_names.size(); column++)
+		{
+			std::cout << (column ? "," : "") << run.column_names[column];
+		}
+		std::cout << '\n';
+		for (uint64_t row = 0; row < run.getRowCount(); row++)
+		{
+			for (uint64_t column = 0; column < run.columns.size(); column++)
+			{
+				std::cout << (column ? "," : "") << run.columns[column][row];
+			}
+			std::cout << '\n';
+		}
+	}
+	return 0;
+}